@@ -0,0 +1,326 @@
+// Apps/TintinTools/Source/RenderMain.cpp
+// tintin-render: plays Standard MIDI Files through a headless TinTinProcessor, with
+// the file's tempo map as the playhead, and writes the audio as WAV. Files are
+// rendered in parallel, one processor each, and every file reports how many times
+// faster than real time it rendered, so a fixed set of files is also a repeatable
+// performance workload.
+//
+// usage: tintin-render [options] <file.mid> [<file.mid> ...]
+//
+//   --out <folder>         where the WAVs go (default: next to each MIDI file)
+//   --stems                also write the M and T voices as <name>.M.wav and <name>.T.wav
+//   --rate <Hz>            sample rate (default 48000)
+//   --block <samples>      block size (default 4096)
+//   --bits <16|24|32>      WAV bit depth (default 24)
+//   --jobs <n>             files rendered at once (default: one per core)
+//   --tail <seconds>       longest tail rendered after the last event (default 30)
+//   --samples <folder>     a sample folder or bank instead of the embedded piano
+//   --set <id>=<value>     a parameter by ID, as its text ("mode=T+1", "root=62"), repeatable
+#include "PluginProcessor.h"
+#include "TintinSongFile.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+struct RenderOptions
+{
+    juce::File outFolder;
+    bool stems = false;
+    double sampleRate = 48000.0;
+    int blockSize = 4096;
+    int bits = 24;
+    int jobs = 1;
+    double maxTailSeconds = 30.0;
+    juce::File samples;
+    juce::StringPairArray parameters;
+};
+
+struct RenderResult
+{
+    juce::String error;
+    double audioSeconds = 0.0;
+    double renderSeconds = 0.0; // processBlock and writing, without loading
+};
+
+static bool applyParameters(TinTinProcessor& processor, const juce::StringPairArray& values, juce::String& error)
+{
+    for (auto& id: values.getAllKeys())
+    {
+        juce::RangedAudioParameter* parameter = nullptr;
+
+        for (auto* p: processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(p))
+                if (ranged->getParameterID() == id)
+                    parameter = ranged;
+
+        if (parameter == nullptr)
+        {
+            error = "no parameter " + id;
+            return false;
+        }
+
+        parameter->setValueNotifyingHost(parameter->getValueForText(values[id]));
+    }
+
+    return true;
+}
+
+static std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& file, const RenderOptions& options)
+{
+    juce::WavAudioFormat format;
+    auto stream = file.createOutputStream();
+
+    if (stream == nullptr || ! stream->setPosition(0) || ! stream->truncate().wasOk())
+        return {};
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(
+        format.createWriterFor(stream.get(), options.sampleRate, 2, options.bits, {}, 0));
+
+    if (writer != nullptr)
+        stream.release(); // the writer owns it now
+
+    return writer;
+}
+
+static RenderResult render(const juce::File& midiFile, const RenderOptions& options)
+{
+    RenderResult result;
+
+    TintinSongFile song;
+
+    if (! song.load(midiFile, result.error))
+        return result;
+
+    TinTinProcessor processor;
+
+    // M and T on their own buses, the mix is their sum
+    auto layout = processor.getBusesLayout();
+    layout.outputBuses.getReference(TinTinProcessor::tBus) = juce::AudioChannelSet::stereo();
+
+    if (! processor.setBusesLayout(layout))
+    {
+        result.error = "can't enable the T output";
+        return result;
+    }
+
+    if (options.samples != juce::File())
+        processor.setSampleLibrary(options.samples);
+
+    if (! applyParameters(processor, options.parameters, result.error))
+        return result;
+
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(options.sampleRate, options.blockSize);
+    processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+    // the samples load (and are converted to the rate) in the background
+    for (int waited = 0; (! processor.isSampleSetReady() || processor.isLoadingSamples())
+                             && processor.getSampleLoadError().isEmpty() && waited < 120000;
+         waited += 10)
+        juce::Thread::sleep(10);
+
+    // --samples that can't be read would otherwise render the embedded piano
+    if (processor.getSampleLoadError().isNotEmpty())
+    {
+        result.error = processor.getSampleLoadError();
+        return result;
+    }
+
+    if (! processor.isSampleSetReady())
+    {
+        result.error = "the piano samples didn't load";
+        return result;
+    }
+
+    auto folder = options.outFolder != juce::File() ? options.outFolder : midiFile.getParentDirectory();
+    auto name = midiFile.getFileNameWithoutExtension();
+
+    auto mix = createWriter(folder.getChildFile(name + ".wav"), options);
+    std::unique_ptr<juce::AudioFormatWriter> mStem, tStem;
+
+    if (options.stems)
+    {
+        mStem = createWriter(folder.getChildFile(name + ".M.wav"), options);
+        tStem = createWriter(folder.getChildFile(name + ".T.wav"), options);
+    }
+
+    if (mix == nullptr || (options.stems && (mStem == nullptr || tStem == nullptr)))
+    {
+        result.error = "can't write to " + folder.getFullPathName();
+        return result;
+    }
+
+    TintinSongPlayHead playHead(song);
+    processor.setPlayHead(&playHead);
+
+    auto& events = song.getEvents();
+    auto tail = juce::jmin(options.maxTailSeconds, processor.getTailLengthSeconds());
+    auto totalSamples = (juce::int64) std::ceil((song.getLengthSeconds() + tail) * options.sampleRate);
+
+    juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), options.blockSize);
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (juce::int64 position = 0; position < totalSamples; position += options.blockSize)
+    {
+        auto numSamples = (int) juce::jmin((juce::int64) options.blockSize, totalSamples - position);
+        auto blockEnd = position + numSamples;
+
+        midi.clear();
+
+        for (; nextEvent < events.getNumEvents(); ++nextEvent)
+        {
+            auto& message = events.getEventPointer(nextEvent)->message;
+            auto samplePosition = (juce::int64) std::llround(message.getTimeStamp() * options.sampleRate);
+
+            if (samplePosition >= blockEnd)
+                break;
+
+            midi.addEvent(message, (int) juce::jmax((juce::int64) 0, samplePosition - position));
+        }
+
+        buffer.setSize(buffer.getNumChannels(), numSamples, false, false, true);
+        playHead.setPosition(position, options.sampleRate);
+        processor.processBlock(buffer, midi);
+
+        auto mOutput = processor.getBusBuffer(buffer, false, TinTinProcessor::mBus);
+        auto tOutput = processor.getBusBuffer(buffer, false, TinTinProcessor::tBus);
+
+        if (options.stems)
+        {
+            mStem->writeFromAudioSampleBuffer(mOutput, 0, numSamples);
+            tStem->writeFromAudioSampleBuffer(tOutput, 0, numSamples);
+        }
+
+        for (int ch = 0; ch < mOutput.getNumChannels(); ++ch)
+            mOutput.addFrom(ch, 0, tOutput, juce::jmin(ch, tOutput.getNumChannels() - 1), 0, numSamples);
+
+        mix->writeFromAudioSampleBuffer(mOutput, 0, numSamples);
+    }
+
+    result.renderSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+    result.audioSeconds = (double) totalSamples / options.sampleRate;
+
+    processor.setPlayHead(nullptr);
+    processor.releaseResources();
+    return result;
+}
+
+static void printUsage()
+{
+    std::printf("usage: tintin-render [--out folder] [--stems] [--rate Hz] [--block samples] [--bits 16|24|32]\n"
+                "                     [--jobs n] [--tail seconds] [--samples folder] [--set id=value ...]\n"
+                "                     <file.mid> [<file.mid> ...]\n");
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    RenderOptions options;
+    options.jobs = juce::SystemStats::getNumCpus();
+    juce::Array<juce::File> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg(argv[i]);
+        auto value = [&] { return i + 1 < argc ? juce::String(argv[++i]) : juce::String(); };
+        auto path = [](const juce::String& p) { return juce::File::getCurrentWorkingDirectory().getChildFile(p); };
+
+        if (arg == "--out")
+            options.outFolder = path(value());
+        else if (arg == "--stems")
+            options.stems = true;
+        else if (arg == "--rate")
+            options.sampleRate = juce::jlimit(8000.0, 384000.0, value().getDoubleValue());
+        else if (arg == "--block")
+            options.blockSize = juce::jlimit(1, 65536, value().getIntValue());
+        else if (arg == "--bits")
+            options.bits = value().getIntValue();
+        else if (arg == "--jobs")
+            options.jobs = juce::jmax(1, value().getIntValue());
+        else if (arg == "--tail")
+            options.maxTailSeconds = juce::jmax(0.0, value().getDoubleValue());
+        else if (arg == "--samples")
+            options.samples = path(value());
+        else if (arg == "--set")
+        {
+            auto assignment = value();
+            options.parameters.set(assignment.upToFirstOccurrenceOf("=", false, false).trim(),
+                                   assignment.fromFirstOccurrenceOf("=", false, false).trim());
+        }
+        else if (arg.startsWith("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            files.add(path(arg));
+    }
+
+    if (files.isEmpty() || (options.bits != 16 && options.bits != 24 && options.bits != 32))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.outFolder != juce::File() && ! options.outFolder.createDirectory().wasOk())
+    {
+        std::printf("can't create %s\n", options.outFolder.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    // each thread takes the next file not taken yet
+    std::atomic<int> nextFile {0};
+    juce::CriticalSection resultLock;
+    int failures = 0;
+    double audioSeconds = 0.0;
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    auto worker = [&]
+    {
+        for (auto i = nextFile++; i < files.size(); i = nextFile++)
+        {
+            auto result = render(files[i], options);
+            const juce::ScopedLock sl(resultLock);
+
+            if (result.error.isNotEmpty())
+            {
+                std::printf("%s: %s\n", files[i].getFileName().toRawUTF8(), result.error.toRawUTF8());
+                ++failures;
+                continue;
+            }
+
+            audioSeconds += result.audioSeconds;
+
+            std::printf("%-40s %8.1f s audio in %7.2f s, %7.1fx real time\n",
+                        files[i].getFileName().toRawUTF8(),
+                        result.audioSeconds,
+                        result.renderSeconds,
+                        result.audioSeconds / juce::jmax(1.0e-9, result.renderSeconds));
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < juce::jmin(options.jobs, files.size()); ++t)
+        threads.emplace_back(worker);
+
+    for (auto& t: threads)
+        t.join();
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    std::printf("\n%d file(s), %.1f s of audio in %.2f s on %d thread(s): %.1fx real time\n",
+                files.size() - failures,
+                audioSeconds,
+                seconds,
+                (int) threads.size(),
+                audioSeconds / juce::jmax(1.0e-9, seconds));
+
+    return failures > 0 ? 1 : 0;
+}
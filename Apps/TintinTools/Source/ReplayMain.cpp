@@ -0,0 +1,358 @@
+// Apps/TintinTools/Source/ReplayMain.cpp
+// tintin-replay: plays session captures (see TintinSessionCapture) back through a
+// headless TinTinProcessor, block for block as the host fed them: the same block
+// sizes, MIDI, playhead and parameter moves. Every run starts from a new processor,
+// so the output hash it prints is the same run after run unless the processor
+// changed, and the processBlock times are those of a real session's workload.
+//
+// Record a session by starting the host with TINTIN_CAPTURE_FOLDER set to an
+// absolute folder path; every TinTin instance writes a .tintinsession file there.
+//
+// usage: tintin-replay [options] <file.tintinsession> [...]
+//
+//   --repeat <n>           runs per capture (default 1), each one's hash must match
+//   --wav <file>           also writes the (last) run's output as WAV (one capture only)
+//   --samples <folder>     a sample folder or bank instead of the embedded piano
+//   --rate <Hz>            sample rate if the capture started after prepareToPlay (default 48000)
+#include "PluginProcessor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// the transport as the capture saw it, one block at a time
+class ReplayPlayHead : public juce::AudioPlayHead
+{
+public:
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        if ((record->playHeadFlags & TintinSessionFormat::hasPlayHead) == 0)
+            return {};
+
+        PositionInfo info;
+        info.setIsPlaying((record->playHeadFlags & TintinSessionFormat::isPlaying) != 0);
+
+        if ((record->playHeadFlags & TintinSessionFormat::hasBpm) != 0)
+            info.setBpm(record->bpm);
+
+        if ((record->playHeadFlags & TintinSessionFormat::hasPpq) != 0)
+            info.setPpqPosition(record->ppq);
+
+        if ((record->playHeadFlags & TintinSessionFormat::hasTime) != 0)
+            info.setTimeInSamples(record->timeInSamples);
+
+        return info;
+    }
+
+    const TintinSessionReader::Record* record = nullptr;
+};
+
+struct ReplayOptions
+{
+    int repeat = 1;
+    juce::File wav;
+    juce::File samples;
+    double sampleRate = 48000.0;
+};
+
+struct ReplayResult
+{
+    juce::String error;
+    uint64_t hash = 0;
+    int numBlocks = 0;
+    double audioSeconds = 0.0;
+    std::vector<double> blockSeconds;
+    uint64_t droppedBlocks = 0;
+    bool complete = false; // ended with the end record rather than cut short
+};
+
+static uint64_t fnv1a(uint64_t hash, const void* data, size_t numBytes)
+{
+    auto* bytes = static_cast<const uint8_t*>(data);
+
+    for (size_t i = 0; i < numBytes; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+    return hash;
+}
+
+static double percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+        return 0.0;
+
+    std::sort(values.begin(), values.end());
+    return values[(size_t) std::round(p * (double) (values.size() - 1))];
+}
+
+static bool prepare(TinTinProcessor& processor, double sampleRate, int maxBlockSize, juce::String& error)
+{
+    processor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+    processor.prepareToPlay(sampleRate, maxBlockSize);
+
+    // the samples load (and are converted to the rate) in the background. The host
+    // played whatever was loaded, the replay waits so every run plays the same
+    for (int waited = 0; (! processor.isSampleSetReady() || processor.isLoadingSamples())
+                             && processor.getSampleLoadError().isEmpty() && waited < 120000;
+         waited += 10)
+        juce::Thread::sleep(10);
+
+    // --samples that can't be read would otherwise render the embedded piano
+    if (processor.getSampleLoadError().isNotEmpty())
+    {
+        error = processor.getSampleLoadError();
+        return false;
+    }
+
+    if (! processor.isSampleSetReady())
+    {
+        error = "the piano samples didn't load";
+        return false;
+    }
+
+    return true;
+}
+
+static ReplayResult replay(TintinSessionReader& reader, const ReplayOptions& options, bool writeWav)
+{
+    ReplayResult result;
+    result.hash = 14695981039346656037ull;
+
+    TinTinProcessor processor;
+
+    if (options.samples != juce::File())
+        processor.setSampleLibrary(options.samples);
+
+    // captured with the T bus enabled
+    if (reader.getNumOutputChannels() > processor.getTotalNumOutputChannels())
+    {
+        auto layout = processor.getBusesLayout();
+        layout.outputBuses.getReference(TinTinProcessor::tBus) = juce::AudioChannelSet::stereo();
+
+        if (! processor.setBusesLayout(layout))
+        {
+            result.error = "can't enable the T output";
+            return result;
+        }
+    }
+
+    // the capture's parameter indices to this build's parameters, by ID
+    std::vector<juce::AudioProcessorParameter*> parameters;
+
+    for (auto& id: reader.getParameterIDs())
+    {
+        juce::AudioProcessorParameter* parameter = nullptr;
+
+        for (auto* p: processor.getParameters())
+            if (auto* withID = dynamic_cast<juce::HostedAudioProcessorParameter*>(p))
+                if (withID->getParameterID() == id)
+                    parameter = p;
+
+        if (parameter == nullptr)
+            std::printf("    no parameter %s in this build, its moves are skipped\n", id.toRawUTF8());
+
+        parameters.push_back(parameter);
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+    juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), 4096);
+    double sampleRate = 0.0;
+
+    TintinSessionReader::Record record;
+    ReplayPlayHead playHead;
+    playHead.record = &record;
+    processor.setPlayHead(&playHead);
+
+    reader.rewind();
+
+    while (reader.readNext(record))
+    {
+        if (record.type == TintinSessionFormat::end)
+        {
+            result.droppedBlocks = record.droppedBlocks;
+            result.complete = true;
+            break;
+        }
+
+        if (record.type == TintinSessionFormat::prepare)
+        {
+            sampleRate = record.sampleRate;
+
+            if (! prepare(processor, sampleRate, record.maxBlockSize, result.error))
+                break;
+
+            continue;
+        }
+
+        // a capture started while the host was already playing
+        if (sampleRate <= 0.0)
+        {
+            sampleRate = options.sampleRate;
+
+            if (! prepare(processor, sampleRate, juce::jmax(record.numSamples, 512), result.error))
+                break;
+        }
+
+        if (writeWav && writer == nullptr)
+        {
+            auto stream = options.wav.createOutputStream();
+
+            if (stream == nullptr || ! stream->setPosition(0) || ! stream->truncate().wasOk())
+            {
+                result.error = "can't write " + options.wav.getFullPathName();
+                break;
+            }
+
+            juce::WavAudioFormat format;
+            writer.reset(format.createWriterFor(stream.get(),
+                                                sampleRate,
+                                                (unsigned int) buffer.getNumChannels(),
+                                                24,
+                                                {},
+                                                0));
+
+            if (writer == nullptr)
+            {
+                result.error = "can't write " + options.wav.getFullPathName();
+                break;
+            }
+
+            stream.release(); // the writer owns it now
+        }
+
+        for (auto& [index, value]: record.parameterChanges)
+            if (auto* parameter = (size_t) index < parameters.size() ? parameters[(size_t) index] : nullptr)
+                parameter->setValueNotifyingHost(value);
+
+        buffer.setSize(buffer.getNumChannels(), record.numSamples, false, false, true);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        processor.processBlock(buffer, record.midi);
+        auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+        result.blockSeconds.push_back(juce::Time::highResolutionTicksToSeconds(elapsed));
+        result.audioSeconds += record.numSamples / sampleRate;
+        ++result.numBlocks;
+
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+            result.hash = fnv1a(result.hash, buffer.getReadPointer(ch), sizeof(float) * (size_t) record.numSamples);
+
+        if (writer != nullptr)
+            writer->writeFromAudioSampleBuffer(buffer, 0, record.numSamples);
+    }
+
+    processor.setPlayHead(nullptr);
+    processor.releaseResources();
+    return result;
+}
+
+static void printUsage()
+{
+    std::printf("usage: tintin-replay [--repeat n] [--wav file] [--samples folder] [--rate Hz]\n"
+                "                     <file.tintinsession> [...]\n");
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    ReplayOptions options;
+    juce::Array<juce::File> files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg(argv[i]);
+        auto value = [&] { return i + 1 < argc ? juce::String(argv[++i]) : juce::String(); };
+        auto path = [](const juce::String& p) { return juce::File::getCurrentWorkingDirectory().getChildFile(p); };
+
+        if (arg == "--repeat")
+            options.repeat = juce::jmax(1, value().getIntValue());
+        else if (arg == "--wav")
+            options.wav = path(value());
+        else if (arg == "--samples")
+            options.samples = path(value());
+        else if (arg == "--rate")
+            options.sampleRate = juce::jlimit(8000.0, 384000.0, value().getDoubleValue());
+        else if (arg.startsWith("--"))
+        {
+            printUsage();
+            return 1;
+        }
+        else
+            files.add(path(arg));
+    }
+
+    if (files.isEmpty() || (options.wav != juce::File() && files.size() > 1))
+    {
+        printUsage();
+        return 1;
+    }
+
+    int failures = 0;
+
+    for (auto& file: files)
+    {
+        TintinSessionReader reader;
+        juce::String error;
+
+        if (! reader.open(file, error))
+        {
+            std::printf("%s\n", error.toRawUTF8());
+            ++failures;
+            continue;
+        }
+
+        std::printf("%s\n", file.getFileName().toRawUTF8());
+
+        uint64_t firstHash = 0;
+
+        for (int run = 0; run < options.repeat; ++run)
+        {
+            auto writeWav = options.wav != juce::File() && run == options.repeat - 1;
+            auto result = replay(reader, options, writeWav);
+
+            if (result.error.isNotEmpty())
+            {
+                std::printf("    %s\n", result.error.toRawUTF8());
+                ++failures;
+                break;
+            }
+
+            if (run == 0)
+            {
+                firstHash = result.hash;
+
+                std::printf("    %d blocks, %.1f s of audio%s",
+                            result.numBlocks,
+                            result.audioSeconds,
+                            result.complete ? "" : " (cut short, the capture wasn't stopped)");
+
+                if (result.droppedBlocks > 0)
+                    std::printf(", %llu block(s) missing, dropped while capturing",
+                                (unsigned long long) result.droppedBlocks);
+
+                std::printf("\n");
+            }
+
+            auto totalSeconds = 0.0;
+
+            for (auto s: result.blockSeconds)
+                totalSeconds += s;
+
+            std::printf("    run %d: output %016llx  block p50 %7.3f  p99 %7.3f  max %7.3f ms, %7.1fx real time%s\n",
+                        run + 1,
+                        (unsigned long long) result.hash,
+                        percentile(result.blockSeconds, 0.5) * 1000.0,
+                        percentile(result.blockSeconds, 0.99) * 1000.0,
+                        percentile(result.blockSeconds, 1.0) * 1000.0,
+                        result.audioSeconds / juce::jmax(1.0e-9, totalSeconds),
+                        result.hash != firstHash ? "  DIFFERS from run 1" : "");
+
+            if (result.hash != firstHash)
+                ++failures;
+        }
+    }
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,121 @@
+// Apps/TintinTools/Source/TintinSongFile.cpp
+#include "TintinSongFile.h"
+
+#include <algorithm>
+
+bool TintinSongFile::load(const juce::File& midiFile, juce::String& error)
+{
+    juce::FileInputStream stream(midiFile);
+
+    if (! stream.openedOk())
+    {
+        error = "can't open " + midiFile.getFullPathName();
+        return false;
+    }
+
+    if (! file.readFrom(stream))
+    {
+        error = midiFile.getFileName() + " is not a Standard MIDI File";
+        return false;
+    }
+
+    // the timeline is built from a copy, file keeps its ticks
+    auto midi = file;
+
+    // the tempo map, read in ticks before the timestamps are converted. Files timed
+    // in SMPTE frames have no tempo, they keep the default 120 bpm
+    auto ticksPerQuarter = (int) midi.getTimeFormat();
+
+    if (ticksPerQuarter > 0)
+    {
+        juce::MidiMessageSequence tempoEvents;
+        midi.findAllTempoEvents(tempoEvents);
+
+        tempos.assign(1, Tempo {});
+
+        for (auto* e: tempoEvents)
+        {
+            auto previous = tempos.back();
+
+            Tempo next;
+            next.ppq = e->message.getTimeStamp() / ticksPerQuarter;
+            next.seconds = previous.seconds + (next.ppq - previous.ppq) * 60.0 / previous.bpm;
+            next.bpm = 60.0 / e->message.getTempoSecondsPerQuarterNote();
+
+            // a change at the same point (e.g. the tempo at 0) replaces the one before
+            if (next.ppq > previous.ppq)
+                tempos.push_back(next);
+            else
+                tempos.back() = next;
+        }
+    }
+
+    midi.convertTimestampTicksToSeconds();
+
+    events.clear();
+
+    for (int t = 0; t < midi.getNumTracks(); ++t)
+    {
+        auto* track = midi.getTrack(t);
+
+        for (auto* e: *track)
+            if (! e->message.isMetaEvent() && ! e->message.isSysEx())
+                events.addEvent(e->message);
+    }
+
+    events.sort();
+    events.updateMatchedPairs();
+
+    lengthSeconds = events.getNumEvents() > 0 ? events.getEndTime() : 0.0;
+    return true;
+}
+
+const TintinSongFile::Tempo& TintinSongFile::tempoAt(double seconds) const noexcept
+{
+    auto next = std::upper_bound(tempos.begin(),
+                                 tempos.end(),
+                                 seconds,
+                                 [](double s, const Tempo& t) { return s < t.seconds; });
+
+    return next == tempos.begin() ? tempos.front() : *(next - 1);
+}
+
+double TintinSongFile::getTicksAt(double seconds) const noexcept
+{
+    auto timeFormat = (int) file.getTimeFormat();
+
+    if (timeFormat > 0)
+        return getPpqAt(seconds) * timeFormat;
+
+    // SMPTE: frames per second in the high byte (negated), ticks per frame in the low
+    // one, read the way juce::MidiFile::convertTimestampTicksToSeconds() reads them
+    auto framesPerSecond = (double) (-(timeFormat >> 8));
+
+    if (framesPerSecond == 29.0)
+        framesPerSecond = 29.97;
+
+    return seconds * framesPerSecond * (double) (timeFormat & 0xff);
+}
+
+double TintinSongFile::getBpmAt(double seconds) const noexcept
+{
+    return tempoAt(seconds).bpm;
+}
+
+double TintinSongFile::getPpqAt(double seconds) const noexcept
+{
+    auto& tempo = tempoAt(seconds);
+    return tempo.ppq + (seconds - tempo.seconds) * tempo.bpm / 60.0;
+}
+
+juce::Optional<juce::AudioPlayHead::PositionInfo> TintinSongPlayHead::getPosition() const
+{
+    PositionInfo info;
+    info.setIsPlaying(true);
+    info.setTimeInSamples(samplePosition);
+    info.setTimeInSeconds(seconds);
+    info.setBpm(song.getBpmAt(seconds));
+    info.setPpqPosition(song.getPpqAt(seconds));
+
+    return info;
+}
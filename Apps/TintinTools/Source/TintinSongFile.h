@@ -0,0 +1,67 @@
+// Apps/TintinTools/Source/TintinSongFile.h
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include <vector>
+
+// a Standard MIDI File flattened for offline playback: the channel events of all
+// tracks on one timeline in seconds, and the file's tempo map to tell a playhead
+// the tempo and quarter-note position at any point of it
+class TintinSongFile
+{
+public:
+    // false (with the reason in error) if midiFile can't be read as a MIDI file
+    bool load(const juce::File& midiFile, juce::String& error);
+
+    // note, controller, pitch bend etc. events, sorted, timestamps in seconds
+    const juce::MidiMessageSequence& getEvents() const noexcept { return events; }
+
+    // time of the last event
+    double getLengthSeconds() const noexcept { return lengthSeconds; }
+
+    // the file as it was read, all tracks, meta events included, timestamps in ticks
+    const juce::MidiFile& getFile() const noexcept { return file; }
+
+    // a time in seconds in the file's own ticks, for events written back to it
+    double getTicksAt(double seconds) const noexcept;
+
+    double getBpmAt(double seconds) const noexcept;
+    double getPpqAt(double seconds) const noexcept;
+
+private:
+    // a tempo change, from where on the tempo holds
+    struct Tempo
+    {
+        double seconds = 0.0;
+        double ppq = 0.0;
+        double bpm = 120.0;
+    };
+
+    const Tempo& tempoAt(double seconds) const noexcept;
+
+    juce::MidiFile file;
+    juce::MidiMessageSequence events;
+    std::vector<Tempo> tempos {Tempo {}}; // the file's first tempo is also the one at 0
+    double lengthSeconds = 0.0;
+};
+
+// plays a song's tempo map to a processor. The caller moves it on before each block
+class TintinSongPlayHead : public juce::AudioPlayHead
+{
+public:
+    explicit TintinSongPlayHead(const TintinSongFile& songFile) : song(songFile) {}
+
+    void setPosition(juce::int64 samples, double sampleRate) noexcept
+    {
+        samplePosition = samples;
+        seconds = (double) samples / sampleRate;
+    }
+
+    juce::Optional<PositionInfo> getPosition() const override;
+
+private:
+    const TintinSongFile& song;
+    juce::int64 samplePosition = 0;
+    double seconds = 0.0;
+};
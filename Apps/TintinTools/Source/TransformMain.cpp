@@ -0,0 +1,419 @@
+// Apps/TintinTools/Source/TransformMain.cpp
+// tintin-transform: runs Standard MIDI Files through TintinMapper, without any
+// audio, and writes each one back with the T voice added as a track of its own.
+// Lists of roots, modes or scales sweep over every combination of them, one output
+// file each. Files (and settings) are spread over a thread per core, and the run
+// reports the input note events per second it got through.
+//
+// usage: tintin-transform [options] <file.mid or folder> [...]
+//
+//   --out <folder>          where the files go (default: next to each input), with the
+//                           subfolders of a folder input made again inside it
+//   --root <note>[,...]     chord root as a MIDI note (default 60)
+//   --triad major|minor     (default major)
+//   --mode <mode>[,...]     none, plus1, plus2, minus1, minus2, orbit or all (default plus1)
+//   --scale <index>[,...]   quantizer scale 0..9 or all, 0 = chromatic (default 0)
+//   --octave <n>            T voice octave offset -3..3
+//   --velocity <v>          follow, fixed:<1..127> or scaled:<0..1> (default follow)
+//   --sync <index>          displace the T voice by sync value 0..15, at the file's tempo
+//   --delay <ms>            displace the T voice by a time instead
+//   --t-only                leave the input's notes out, keep only its tempo map and the T voice
+//   --jobs <n>              threads (default: one per core)
+//
+// Folders are searched for .mid and .midi files, including their subfolders. Every
+// file written ends in .tintin.mid, and those are left out of the search, so a
+// second run over the same folder doesn't transform its own output again.
+#include "TintinMapper.h"
+#include "TintinSongFile.h"
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <set>
+#include <thread>
+#include <vector>
+
+using TMode = TintinSettings::TMode;
+
+static constexpr double timelineRate = 48000.0; // the mapper's clock, in samples per second
+static constexpr int blockSize = 4096;
+static constexpr int numScales = 10;
+static constexpr const char* outputSuffix = ".tintin";
+
+static const std::pair<TMode, const char*> modeNames[] = {{TMode::None, "none"},
+                                                          {TMode::Plus1, "plus1"},
+                                                          {TMode::Plus2, "plus2"},
+                                                          {TMode::Minus1, "minus1"},
+                                                          {TMode::Minus2, "minus2"},
+                                                          {TMode::Orbit, "orbit"}};
+
+static const char* getModeName(TMode mode)
+{
+    for (auto& [m, name]: modeNames)
+        if (m == mode)
+            return name;
+
+    return "";
+}
+
+struct Job
+{
+    juce::File input;
+    juce::File output;
+    TintinSettings settings;
+};
+
+struct Totals
+{
+    juce::int64 eventsIn = 0;   // input note ons and offs
+    juce::int64 eventsOut = 0;  // T note ons and offs
+    double mapperSeconds = 0.0; // in TintinMapper::process only
+};
+
+// the input's tracks (or only their meta events with tOnly) plus a T track.
+// False if the file can't be read or written
+static bool transform(const Job& job, bool tOnly, Totals& totals, juce::String& error)
+{
+    TintinSongFile song;
+
+    if (! song.load(job.input, error))
+        return false;
+
+    TintinMapper mapper;
+    mapper.settings = job.settings;
+    mapper.settings.mVoiceOn = false; // the input's own tracks are the M voice
+    mapper.prepare();
+
+    juce::MidiMessageSequence tTrack;
+    tTrack.addEvent(juce::MidiMessage::textMetaEvent(3, "T voice"));
+
+    auto& events = song.getEvents();
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+    juce::int64 ticks = 0;
+
+    // until the input is through and the last displaced note has come out
+    for (juce::int64 position = 0; nextEvent < events.getNumEvents() || ! mapper.scheduler.isEmpty();
+         position += blockSize)
+    {
+        midi.clear();
+
+        for (; nextEvent < events.getNumEvents(); ++nextEvent)
+        {
+            auto& message = events.getEventPointer(nextEvent)->message;
+            auto samplePosition = (juce::int64) std::llround(message.getTimeStamp() * timelineRate);
+
+            if (samplePosition >= position + blockSize)
+                break;
+
+            if (message.isNoteOnOrOff())
+            {
+                midi.addEvent(message, (int) juce::jmax((juce::int64) 0, samplePosition - position));
+                ++totals.eventsIn;
+            }
+        }
+
+        mapper.settings.bpm = song.getBpmAt((double) position / timelineRate);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        mapper.process(midi, timelineRate, blockSize);
+        ticks += juce::Time::getHighResolutionTicks() - start;
+
+        for (const auto m: mapper.tEvents)
+        {
+            auto message = m.getMessage();
+            auto seconds = (double) (position + m.samplePosition) / timelineRate;
+            message.setTimeStamp(std::round(song.getTicksAt(seconds)));
+            tTrack.addEvent(message);
+            ++totals.eventsOut;
+        }
+    }
+
+    totals.mapperSeconds += juce::Time::highResolutionTicksToSeconds(ticks);
+
+    tTrack.updateMatchedPairs();
+
+    auto& source = song.getFile();
+    juce::MidiFile result;
+
+    if (source.getTimeFormat() > 0)
+        result.setTicksPerQuarterNote(source.getTimeFormat());
+    else
+        result.setSmpteTimeFormat(-(source.getTimeFormat() >> 8), source.getTimeFormat() & 0xff);
+
+    for (int t = 0; t < source.getNumTracks(); ++t)
+    {
+        if (! tOnly)
+        {
+            result.addTrack(*source.getTrack(t));
+            continue;
+        }
+
+        juce::MidiMessageSequence meta;
+
+        for (auto* e: *source.getTrack(t))
+            if (e->message.isMetaEvent())
+                meta.addEvent(e->message);
+
+        if (meta.getNumEvents() > 0)
+            result.addTrack(meta);
+    }
+
+    result.addTrack(tTrack);
+
+    job.output.deleteFile();
+    juce::FileOutputStream stream(job.output);
+
+    if (! stream.openedOk() || ! result.writeTo(stream))
+    {
+        error = "can't write " + job.output.getFullPathName();
+        return false;
+    }
+
+    return true;
+}
+
+// "60,62" or "all" (everything from 0 to count - 1) as numbers
+static juce::Array<int> parseList(const juce::String& text,
+                                  int count,
+                                  const std::function<int(const juce::String&)>& parse)
+{
+    juce::Array<int> values;
+
+    if (text.trim() == "all")
+    {
+        for (int i = 0; i < count; ++i)
+            values.add(i);
+
+        return values;
+    }
+
+    for (auto& item: juce::StringArray::fromTokens(text, ",", ""))
+        values.add(parse(item.trim()));
+
+    return values;
+}
+
+static void printUsage()
+{
+    std::printf("usage: tintin-transform [--out folder] [--root n,...] [--triad major|minor] [--mode m,...|all]\n"
+                "                        [--scale n,...|all] [--octave n] [--velocity follow|fixed:v|scaled:s]\n"
+                "                        [--sync index | --delay ms] [--t-only] [--jobs n]\n"
+                "                        <file.mid or folder> [...]\n");
+}
+
+int main(int argc, char* argv[])
+{
+    TintinSettings base;
+    juce::Array<int> roots {base.rootNote};
+    juce::Array<int> modes {(int) base.mode};
+    juce::Array<int> scales {base.scaleIndex};
+    juce::File outFolder;
+    bool tOnly = false;
+    auto numThreads = juce::SystemStats::getNumCpus();
+    juce::Array<juce::File> inputs;
+    bool valid = true;
+
+    auto rootNumber = [](const juce::String& s) { return juce::jlimit(0, 127, s.getIntValue()); };
+    auto scaleNumber = [](const juce::String& s) { return juce::jlimit(0, numScales - 1, s.getIntValue()); };
+
+    auto modeIndex = [&](const juce::String& name)
+    {
+        for (auto& [m, modeName]: modeNames)
+            if (name == modeName)
+                return (int) m;
+
+        valid = false;
+        return 0;
+    };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        juce::String arg(argv[i]);
+        auto value = [&] { return i + 1 < argc ? juce::String(argv[++i]) : juce::String(); };
+        auto path = [](const juce::String& p) { return juce::File::getCurrentWorkingDirectory().getChildFile(p); };
+
+        if (arg == "--out")
+            outFolder = path(value());
+        else if (arg == "--root")
+            roots = parseList(value(), 128, rootNumber);
+        else if (arg == "--triad")
+            base.triad = value() == "minor" ? TintinSettings::TriadType::Minor : TintinSettings::TriadType::Major;
+        else if (arg == "--mode")
+            modes = parseList(value(), (int) std::size(modeNames), modeIndex);
+        else if (arg == "--scale")
+            scales = parseList(value(), numScales, scaleNumber);
+        else if (arg == "--octave")
+            base.octaveOffset = juce::jlimit(-3, 3, value().getIntValue());
+        else if (arg == "--velocity")
+        {
+            auto v = value();
+            auto amount = v.fromFirstOccurrenceOf(":", false, false);
+
+            if (v.startsWith("fixed"))
+            {
+                base.velocityMode = TintinSettings::VelocityMode::Fixed;
+                base.fixedVelocity = juce::jlimit(1, 127, amount.getIntValue());
+            }
+            else if (v.startsWith("scaled"))
+            {
+                base.velocityMode = TintinSettings::VelocityMode::Scaled;
+                base.velocityScale = juce::jlimit(0.0f, 1.0f, amount.getFloatValue());
+            }
+        }
+        else if (arg == "--sync")
+        {
+            base.displacementMode = TintinSettings::DisplacementMode::Sync;
+            base.syncIndex = juce::jlimit(0, 15, value().getIntValue());
+        }
+        else if (arg == "--delay")
+        {
+            base.displacementMode = TintinSettings::DisplacementMode::Absolute;
+            base.displacementMs = juce::jmax(0.0f, value().getFloatValue());
+        }
+        else if (arg == "--t-only")
+            tOnly = true;
+        else if (arg == "--jobs")
+            numThreads = juce::jmax(1, value().getIntValue());
+        else if (arg.startsWith("--"))
+            valid = false;
+        else
+            inputs.add(path(arg));
+    }
+
+    if (! valid || inputs.isEmpty() || roots.isEmpty() || modes.isEmpty() || scales.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (outFolder != juce::File() && ! outFolder.createDirectory().wasOk())
+    {
+        std::printf("can't create %s\n", outFolder.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    // every file with every combination of the settings
+    auto sweep = roots.size() * modes.size() * scales.size() > 1;
+    std::vector<Job> jobs;
+    std::set<juce::String> outputs;
+
+    for (auto& input: inputs)
+    {
+        juce::Array<juce::File> files;
+
+        if (input.isDirectory())
+        {
+            for (auto& file: input.findChildFiles(juce::File::findFiles, true, "*.mid;*.midi"))
+                if (! file.getFileNameWithoutExtension().endsWith(outputSuffix))
+                    files.add(file);
+        }
+        else
+        {
+            files.add(input);
+        }
+
+        for (auto& file: files)
+        {
+            // a file from a folder keeps its place below that folder
+            auto folder = file.getParentDirectory();
+
+            if (outFolder != juce::File())
+            {
+                folder = input.isDirectory() ? outFolder.getChildFile(folder.getRelativePathFrom(input)) : outFolder;
+
+                if (! folder.createDirectory().wasOk())
+                {
+                    std::printf("can't create %s\n", folder.getFullPathName().toRawUTF8());
+                    return 1;
+                }
+            }
+
+            for (auto root: roots)
+            {
+                for (auto mode: modes)
+                {
+                    for (auto scale: scales)
+                    {
+                        Job job {file, {}, base};
+                        job.settings.rootNote = root;
+                        job.settings.mode = (TMode) mode;
+                        job.settings.scaleIndex = scale;
+
+                        auto name = file.getFileNameWithoutExtension();
+
+                        if (sweep)
+                            name << "." << getModeName(job.settings.mode) << ".root" << root << ".scale" << scale;
+
+                        job.output = folder.getChildFile(name + outputSuffix + ".mid");
+
+                        // two inputs of the same name would write one file from two threads
+                        if (! outputs.insert(job.output.getFullPathName()).second)
+                        {
+                            std::printf("%s: %s is written for another input already, use --out with folders\n",
+                                        file.getFullPathName().toRawUTF8(),
+                                        job.output.getFullPathName().toRawUTF8());
+                            return 1;
+                        }
+
+                        jobs.push_back(job);
+                    }
+                }
+            }
+        }
+    }
+
+    // each thread takes the next job not taken yet
+    std::atomic<size_t> nextJob {0};
+    juce::CriticalSection resultLock;
+    Totals totals;
+    int failures = 0;
+
+    auto start = juce::Time::getHighResolutionTicks();
+
+    auto worker = [&]
+    {
+        Totals own;
+
+        for (auto i = nextJob++; i < jobs.size(); i = nextJob++)
+        {
+            juce::String error;
+
+            if (! transform(jobs[i], tOnly, own, error))
+            {
+                const juce::ScopedLock sl(resultLock);
+                std::printf("%s: %s\n", jobs[i].input.getFileName().toRawUTF8(), error.toRawUTF8());
+                ++failures;
+            }
+        }
+
+        const juce::ScopedLock sl(resultLock);
+        totals.eventsIn += own.eventsIn;
+        totals.eventsOut += own.eventsOut;
+        totals.mapperSeconds += own.mapperSeconds;
+    };
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < juce::jmin(numThreads, (int) jobs.size()); ++t)
+        threads.emplace_back(worker);
+
+    for (auto& t: threads)
+        t.join();
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    std::printf("%d file(s) written, %d failed, in %.2f s on %d thread(s)\n",
+                (int) jobs.size() - failures,
+                failures,
+                seconds,
+                (int) threads.size());
+
+    std::printf("%lld note events in, %lld T events out: %.0f events/s overall, %.0f per thread in the mapper\n",
+                (long long) totals.eventsIn,
+                (long long) totals.eventsOut,
+                (double) totals.eventsIn / juce::jmax(1.0e-9, seconds),
+                (double) totals.eventsIn / juce::jmax(1.0e-9, totals.mapperSeconds));
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,403 @@
+// Benchmarks/CoreBenchmark.cpp
+// Throughput of the MIDI core: TintinMapper::process across event densities,
+// displacement lengths, T-modes and block sizes, TintinQuantizer::quantize per
+// scale and TintinScheduler::processBlock with growing queues, steady loads of up
+// to 64000 pending events and bursts all due at once. Each case reports the median
+// ns per event over a few rounds and the events per second that gives.
+//
+// usage: TinTinCoreBenchmark [--seconds s] [--json results.json]
+//                            [--baseline baseline.json] [--threshold 0.2]
+//
+// --seconds is the audio each mapper round simulates (default 1). --json writes
+// the results, which can be kept as a baseline. With --baseline the run fails
+// (exit code 1) if a case got slower than the baseline by more than --threshold
+// (0.2 = 20 %). Cases the baseline doesn't have are only listed.
+#include "TintinMapper.h"
+#include "TintinQuantizer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+static constexpr double sampleRate = 48000.0;
+static constexpr int numRounds = 5;
+
+struct Result
+{
+    juce::String name;
+    double nsPerEvent = 0.0;
+};
+
+// events handled in a round and the seconds that part took, set-up excluded
+struct Timing
+{
+    juce::int64 events = 0;
+    double seconds = 0.0;
+};
+
+template <typename Fn>
+static Timing timed(Fn&& fn)
+{
+    auto start = juce::Time::getHighResolutionTicks();
+    auto events = fn();
+    auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+    return {events, juce::Time::highResolutionTicksToSeconds(elapsed)};
+}
+
+// runs round() numRounds times after one warm-up call. Median of the rounds, in ns per event
+static double measure(const std::function<Timing()>& round)
+{
+    round();
+
+    std::vector<double> ns;
+
+    for (int i = 0; i < numRounds; ++i)
+    {
+        auto t = round();
+        ns.push_back(t.seconds * 1.0e9 / (double) juce::jmax((juce::int64) 1, t.events));
+    }
+
+    std::sort(ns.begin(), ns.end());
+    return ns[ns.size() / 2];
+}
+
+static void report(std::vector<Result>& results, const juce::String& name, double nsPerEvent)
+{
+    std::printf("%-48s %10.1f ns/event  %12.0f events/s\n", name.toRawUTF8(), nsPerEvent, 1.0e9 / nsPerEvent);
+    results.push_back({name, nsPerEvent});
+}
+
+struct Displacement
+{
+    const char* name;
+    TintinSettings::DisplacementMode mode;
+    int syncIndex;
+    float ms;
+};
+
+// feeds eventsPerSecond note events (on/off pairs on random keys) through a
+// mapper for the given audio length, block by block
+static juce::int64 runMapper(TintinMapper& mapper, juce::Random& random, double eventsPerSecond, int blockSize, double seconds)
+{
+    juce::MidiBuffer midi;
+    int held[128] = {};
+
+    auto numBlocks = (int) (seconds * sampleRate / blockSize);
+    auto eventsPerBlock = eventsPerSecond * blockSize / sampleRate;
+    auto due = 0.0;
+    juce::int64 events = 0;
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        midi.clear();
+
+        for (due += eventsPerBlock; due >= 1.0; due -= 1.0)
+        {
+            auto note = 36 + random.nextInt(48);
+            auto position = random.nextInt(blockSize);
+
+            if (held[note] > 0)
+            {
+                midi.addEvent(juce::MidiMessage::noteOff(1, note), position);
+                --held[note];
+            }
+            else
+            {
+                midi.addEvent(juce::MidiMessage::noteOn(1, note, (juce::uint8) (1 + random.nextInt(127))), position);
+                ++held[note];
+            }
+
+            ++events;
+        }
+
+        mapper.process(midi, sampleRate, blockSize);
+    }
+
+    return events;
+}
+
+static void benchmarkMapper(std::vector<Result>& results, double seconds)
+{
+    using TMode = TintinSettings::TMode;
+    using DM = TintinSettings::DisplacementMode;
+
+    const Displacement displacements[] = {{"none", DM::None, 0, 0.0f},
+                                          {"1_16", DM::Sync, 0, 0.0f},
+                                          {"1bar", DM::Sync, 12, 0.0f},
+                                          {"2000ms", DM::Absolute, 0, 2000.0f}};
+
+    const std::pair<TMode, const char*> modes[] = {{TMode::None, "none"},
+                                                   {TMode::Plus1, "plus1"},
+                                                   {TMode::Plus2, "plus2"},
+                                                   {TMode::Minus1, "minus1"},
+                                                   {TMode::Minus2, "minus2"},
+                                                   {TMode::Orbit, "orbit"}};
+
+    auto run = [&](TMode mode, const char* modeName, const Displacement& d, double density, int blockSize)
+    {
+        TintinSettings settings;
+        settings.mode = mode;
+        settings.displacementMode = d.mode;
+        settings.syncIndex = d.syncIndex;
+        settings.displacementMs = d.ms;
+        settings.scaleIndex = 1;
+        settings.bpm = 120.0;
+
+        auto nsPerEvent = measure([&]
+        {
+            TintinMapper mapper;
+            mapper.settings = settings;
+            juce::Random random(42);
+
+            // first the delay's worth of audio, so the scheduler queue is at its steady size
+            runMapper(mapper, random, density, blockSize, TintinMapper::getLatestEventSeconds(settings));
+
+            return timed([&] { return runMapper(mapper, random, density, blockSize, seconds); });
+        });
+
+        report(results,
+               juce::String("mapper/") + modeName + "/" + d.name + "/" + juce::String((int) density) + "ev/"
+                   + juce::String(blockSize),
+               nsPerEvent);
+    };
+
+    // density, displacement and block size against each other
+    for (auto& d: displacements)
+        for (auto density: {100.0, 1000.0, 10000.0})
+            for (auto blockSize: {64, 512, 4096})
+                run(TMode::Plus1, "plus1", d, density, blockSize);
+
+    // every mode at one middle setting
+    for (auto [mode, name]: modes)
+        run(mode, name, displacements[1], 1000.0, 512);
+}
+
+static void benchmarkQuantizer(std::vector<Result>& results)
+{
+    for (int scale = 0; scale < 10; ++scale)
+    {
+        volatile int sink = 0;
+
+        auto nsPerEvent = measure([&]
+        {
+            return timed([&]
+            {
+                constexpr int calls = 200000;
+
+                for (int i = 0; i < calls; ++i)
+                    sink = sink + TintinQuantizer::quantize(i % 128, scale, 60);
+
+                return (juce::int64) calls;
+            });
+        });
+
+        report(results, "quantizer/scale" + juce::String(scale), nsPerEvent);
+    }
+}
+
+// a queue of numPending events all due later than the run lasts, so every block
+// walks the whole queue. ns per queued event per block
+static void benchmarkScheduler(std::vector<Result>& results)
+{
+    for (auto numPending: {100, 10000})
+    {
+        for (auto blockSize: {64, 512, 4096})
+        {
+            auto nsPerEvent = measure([&]
+            {
+                constexpr int numBlocks = 200;
+
+                TintinScheduler scheduler;
+                juce::MidiBuffer out;
+
+                for (int i = 0; i < numPending; ++i)
+                    scheduler.add(juce::MidiMessage::noteOn(1, i % 128, (juce::uint8) 100),
+                                  numBlocks * blockSize + i,
+                                  0);
+
+                return timed([&]
+                {
+                    for (int b = 0; b < numBlocks; ++b)
+                        scheduler.processBlock(out, blockSize);
+
+                    return (juce::int64) numPending * numBlocks;
+                });
+            });
+
+            report(results, "scheduler/" + juce::String(numPending) + "pending/" + juce::String(blockSize), nsPerEvent);
+        }
+    }
+}
+
+// a steady queue of about numPending events with random delays, events added and
+// coming due every block, so the cost per event shows how it grows with the load
+static void benchmarkSchedulerLoad(std::vector<Result>& results)
+{
+    constexpr int blockSize = 256;
+    constexpr int addsPerBlock = 32;
+
+    for (auto numPending: {1000, 4000, 16000, 64000})
+    {
+        // added uniformly over the span, so on average numPending are waiting
+        auto spanBlocks = 2 * numPending / addsPerBlock;
+
+        auto nsPerEvent = measure([&]
+        {
+            TintinScheduler scheduler;
+            juce::MidiBuffer out;
+            juce::Random random(7);
+
+            auto runBlocks = [&](int numBlocks)
+            {
+                juce::int64 events = 0;
+
+                for (int b = 0; b < numBlocks; ++b)
+                {
+                    for (int i = 0; i < addsPerBlock; ++i)
+                        scheduler.add(juce::MidiMessage::noteOn(1, i, (juce::uint8) 100),
+                                      random.nextInt(spanBlocks * blockSize),
+                                      random.nextInt(blockSize));
+
+                    out.clear();
+                    scheduler.processBlock(out, blockSize);
+                    events += addsPerBlock + out.getNumEvents();
+                }
+
+                return events;
+            };
+
+            runBlocks(spanBlocks);
+
+            return timed([&] { return runBlocks(500); });
+        });
+
+        report(results, "scheduler/load/" + juce::String(numPending) + "pending", nsPerEvent);
+    }
+
+    // all of them due on the same sample of one block, the worst a block gets
+    for (auto numDue: {1000, 10000})
+    {
+        auto nsPerEvent = measure([&]
+        {
+            TintinScheduler scheduler;
+            juce::MidiBuffer out;
+
+            for (int i = 0; i < numDue; ++i)
+                scheduler.add(juce::MidiMessage::noteOn(1, i % 128, (juce::uint8) 100), 1000, 0);
+
+            return timed([&]
+            {
+                scheduler.processBlock(out, 4096);
+                return (juce::int64) numDue;
+            });
+        });
+
+        report(results, "scheduler/burst/" + juce::String(numDue) + "due", nsPerEvent);
+    }
+}
+
+static bool writeResults(const std::vector<Result>& results, const juce::File& file)
+{
+    auto* cases = new juce::DynamicObject();
+
+    for (auto& r: results)
+        cases->setProperty(r.name, r.nsPerEvent);
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("unit", "ns/event");
+    root->setProperty("cases", juce::var(cases));
+
+    return file.replaceWithText(juce::JSON::toString(juce::var(root)));
+}
+
+// number of cases slower than the baseline by more than threshold
+static int compareWithBaseline(const std::vector<Result>& results, const juce::File& file, double threshold)
+{
+    auto baseline = juce::JSON::parse(file)["cases"];
+
+    if (! baseline.isObject())
+    {
+        std::printf("\ncan't read a baseline from %s\n", file.getFullPathName().toRawUTF8());
+        return 1;
+    }
+
+    std::printf("\nagainst %s, threshold %+.0f %%\n", file.getFullPathName().toRawUTF8(), threshold * 100.0);
+
+    int failures = 0;
+
+    for (auto& r: results)
+    {
+        auto saved = baseline[juce::Identifier(r.name)];
+
+        if (saved.isVoid())
+        {
+            std::printf("%-48s new\n", r.name.toRawUTF8());
+            continue;
+        }
+
+        auto change = r.nsPerEvent / (double) saved - 1.0;
+        auto failed = change > threshold;
+        failures += failed ? 1 : 0;
+
+        std::printf("%-48s %+7.1f %%%s\n", r.name.toRawUTF8(), change * 100.0, failed ? "  SLOWER" : "");
+    }
+
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    auto option = [&](const char* name) -> juce::String
+    {
+        auto index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : juce::String();
+    };
+
+    auto seconds = option("--seconds").isEmpty() ? 1.0 : juce::jmax(0.1, option("--seconds").getDoubleValue());
+    auto threshold = option("--threshold").isEmpty() ? 0.2 : option("--threshold").getDoubleValue();
+
+    std::printf("TinTin core benchmark, %.1f s of audio per mapper round, median of %d rounds\n\n",
+                seconds,
+                numRounds);
+
+    std::vector<Result> results;
+    benchmarkMapper(results, seconds);
+    benchmarkQuantizer(results);
+    benchmarkScheduler(results);
+    benchmarkSchedulerLoad(results);
+
+    if (auto json = option("--json"); json.isNotEmpty())
+    {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile(json);
+
+        if (! writeResults(results, file))
+        {
+            std::printf("\ncan't write %s\n", file.getFullPathName().toRawUTF8());
+            return 1;
+        }
+    }
+
+    if (auto baseline = option("--baseline"); baseline.isNotEmpty())
+    {
+        auto failures = compareWithBaseline(results,
+                                            juce::File::getCurrentWorkingDirectory().getChildFile(baseline),
+                                            threshold);
+
+        if (failures > 0)
+        {
+            std::printf("\n%d case(s) slower than the baseline\n", failures);
+            return 1;
+        }
+    }
+
+    return 0;
+}
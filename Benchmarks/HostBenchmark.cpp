@@ -0,0 +1,373 @@
+// Benchmarks/HostBenchmark.cpp
+// Simulates a host running many TinTin instances: every period it hands all of
+// them a block and has a set of audio threads process them in parallel, each
+// thread taking the next instance not taken yet, the way hosts spread plugins over
+// their worker threads. Every instance gets its own synthetic MIDI (notes, pedal)
+// and a playhead with its own tempo changes.
+//
+// Per buffer size it reports the time the whole period took (p50, p99, max) and how
+// often it missed its deadline (the period's length in audio), then per instance the
+// time spent in processBlock as a share of real time with its p99 and max block. If
+// instances slow each other down through shared state, caches or false sharing, the
+// period times grow faster than the instances' own times as threads are added.
+//
+// usage: TinTinHostBenchmark [--instances n] [--threads n] [--blocks 64,128,...]
+//                            [--seconds s] [--density events/s] [--realtime]
+//
+// --instances (default 32) and --threads (default one per core) set the session,
+// --blocks the buffer sizes (default 64,128,256,512,1024) and --seconds the audio
+// rendered at each (default 10). --density is note events per second and instance
+// (default 20). --realtime waits for each period to come round like a live host
+// does instead of running the periods back to back.
+#include "PluginProcessor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static constexpr double sampleRate = 48000.0;
+
+// a transport that plays at a tempo of its own, changing now and then
+class BenchmarkPlayHead : public juce::AudioPlayHead
+{
+public:
+    juce::Optional<PositionInfo> getPosition() const override
+    {
+        PositionInfo info;
+        info.setIsPlaying(true);
+        info.setTimeInSamples(samples);
+        info.setTimeInSeconds((double) samples / sampleRate);
+        info.setBpm(bpm);
+        info.setPpqPosition(ppq);
+        return info;
+    }
+
+    void advance(int numSamples) noexcept
+    {
+        samples += numSamples;
+        ppq += numSamples / sampleRate * bpm / 60.0;
+    }
+
+    double bpm = 120.0;
+
+private:
+    juce::int64 samples = 0;
+    double ppq = 0.0;
+};
+
+// one plugin instance and what the host keeps for it. Aligned so instances
+// processed on different threads don't share cache lines
+struct alignas(64) Instance
+{
+    TinTinProcessor processor;
+    BenchmarkPlayHead playHead;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+    juce::Random random;
+    double due = 0.0;
+    bool held[128] = {};
+
+    std::vector<double> blockSeconds; // one per period, preallocated
+    double totalSeconds = 0.0;
+
+    // a few notes and pedal moves per block, at eventsPerSecond on average
+    void fillMidi(int numSamples, double eventsPerSecond)
+    {
+        midi.clear();
+
+        for (due += eventsPerSecond * numSamples / sampleRate; due >= 1.0; due -= 1.0)
+        {
+            auto position = random.nextInt(numSamples);
+
+            if (random.nextInt(16) == 0)
+            {
+                midi.addEvent(juce::MidiMessage::controllerEvent(1, 64, random.nextBool() ? 127 : 0), position);
+                continue;
+            }
+
+            auto note = 36 + random.nextInt(60);
+
+            if (held[note])
+                midi.addEvent(juce::MidiMessage::noteOff(1, note), position);
+            else
+                midi.addEvent(juce::MidiMessage::noteOn(1, note, (juce::uint8) (30 + random.nextInt(98))), position);
+
+            held[note] = ! held[note];
+        }
+
+        if (random.nextInt(2000) == 0)
+            playHead.bpm = 60.0 + random.nextInt(120);
+    }
+};
+
+// the host's audio threads. The calling thread is one of them
+class AudioThreads
+{
+public:
+    AudioThreads(int numThreads, std::vector<std::unique_ptr<Instance>>& sessionInstances)
+        : instances(sessionInstances)
+    {
+        for (int i = 1; i < numThreads; ++i)
+        {
+            auto helper = std::make_unique<Helper>();
+            helper->thread = std::thread([this, h = helper.get()] { runHelper(*h); });
+            helpers.push_back(std::move(helper));
+        }
+    }
+
+    ~AudioThreads()
+    {
+        quit = true;
+
+        for (auto& h: helpers)
+            h->wake.signal();
+
+        for (auto& h: helpers)
+            h->thread.join();
+    }
+
+    // processes every instance once, returns once all of them are done
+    void processPeriod(int numSamples, double eventsPerSecond, int period)
+    {
+        blockSize = numSamples;
+        density = eventsPerSecond;
+        periodIndex = period;
+        nextInstance = 0;
+        helpersLeft = (int) helpers.size();
+
+        for (auto& h: helpers)
+            h->wake.signal();
+
+        takeInstances();
+
+        if (! helpers.empty())
+            finished.wait(-1);
+    }
+
+private:
+    struct Helper
+    {
+        std::thread thread;
+        juce::WaitableEvent wake;
+    };
+
+    void runHelper(Helper& helper)
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        for (;;)
+        {
+            helper.wake.wait(-1);
+
+            if (quit)
+                return;
+
+            takeInstances();
+
+            if (helpersLeft.fetch_sub(1) == 1)
+                finished.signal();
+        }
+    }
+
+    void takeInstances()
+    {
+        for (auto i = nextInstance++; i < (int) instances.size(); i = nextInstance++)
+        {
+            auto& instance = *instances[(size_t) i];
+
+            instance.fillMidi(blockSize, density);
+            instance.buffer.setSize(instance.buffer.getNumChannels(), blockSize, false, false, true);
+
+            auto start = juce::Time::getHighResolutionTicks();
+            instance.processor.processBlock(instance.buffer, instance.midi);
+            auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+            instance.blockSeconds[(size_t) periodIndex] = seconds;
+            instance.totalSeconds += seconds;
+            instance.playHead.advance(blockSize);
+        }
+    }
+
+    std::vector<std::unique_ptr<Instance>>& instances;
+    std::vector<std::unique_ptr<Helper>> helpers;
+
+    int blockSize = 0;
+    double density = 0.0;
+    int periodIndex = 0;
+    std::atomic<int> nextInstance {0};
+    std::atomic<int> helpersLeft {0};
+    std::atomic<bool> quit {false};
+    juce::WaitableEvent finished;
+};
+
+static double percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+        return 0.0;
+
+    std::sort(values.begin(), values.end());
+    return values[(size_t) std::round(p * (double) (values.size() - 1))];
+}
+
+static void run(std::vector<std::unique_ptr<Instance>>& instances,
+                int numThreads,
+                int blockSize,
+                double seconds,
+                double density,
+                bool realtime)
+{
+    auto numPeriods = juce::jmax(1, (int) (seconds * sampleRate / blockSize));
+    auto deadline = blockSize / sampleRate;
+
+    for (auto& instance: instances)
+    {
+        instance->processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        instance->processor.prepareToPlay(sampleRate, blockSize);
+        instance->buffer.setSize(instance->processor.getTotalNumOutputChannels(), blockSize);
+        instance->midi.ensureSize(4096);
+        instance->blockSeconds.assign((size_t) numPeriods, 0.0);
+        instance->totalSeconds = 0.0;
+    }
+
+    std::vector<double> periodSeconds((size_t) numPeriods);
+    int misses = 0;
+
+    {
+        AudioThreads threads(numThreads, instances);
+        juce::ScopedNoDenormals noDenormals;
+
+        auto periodTicks = juce::Time::secondsToHighResolutionTicks(deadline);
+        auto nextPeriod = juce::Time::getHighResolutionTicks();
+
+        for (int p = 0; p < numPeriods; ++p)
+        {
+            if (realtime)
+            {
+                while (juce::Time::getHighResolutionTicks() < nextPeriod)
+                    std::this_thread::yield();
+
+                nextPeriod += periodTicks;
+            }
+
+            auto start = juce::Time::getHighResolutionTicks();
+            threads.processPeriod(blockSize, density, p);
+            auto elapsed = juce::Time::getHighResolutionTicks() - start;
+
+            periodSeconds[(size_t) p] = juce::Time::highResolutionTicksToSeconds(elapsed);
+            misses += periodSeconds[(size_t) p] > deadline ? 1 : 0;
+        }
+    }
+
+    auto audioSeconds = numPeriods * deadline;
+    auto totalSeconds = 0.0;
+
+    for (auto& instance: instances)
+        totalSeconds += instance->totalSeconds;
+
+    std::printf("block %5d (deadline %6.3f ms): period p50 %7.3f  p99 %7.3f  max %7.3f ms, "
+                "%d of %d missed (%.2f %%), processBlock total %.1f %% of one core\n",
+                blockSize,
+                deadline * 1000.0,
+                percentile(periodSeconds, 0.5) * 1000.0,
+                percentile(periodSeconds, 0.99) * 1000.0,
+                percentile(periodSeconds, 1.0) * 1000.0,
+                misses,
+                numPeriods,
+                100.0 * misses / numPeriods,
+                100.0 * totalSeconds / audioSeconds);
+
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+        auto& instance = *instances[i];
+
+        std::printf("    instance %3d: %6.2f %% of real time, p99 %7.3f  max %7.3f ms\n",
+                    (int) i,
+                    100.0 * instance.totalSeconds / audioSeconds,
+                    percentile(instance.blockSeconds, 0.99) * 1000.0,
+                    percentile(instance.blockSeconds, 1.0) * 1000.0);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    juce::StringArray args;
+
+    for (int i = 1; i < argc; ++i)
+        args.add(argv[i]);
+
+    auto option = [&](const char* name) -> juce::String
+    {
+        auto index = args.indexOf(name);
+        return index >= 0 && index + 1 < args.size() ? args[index + 1] : juce::String();
+    };
+
+    auto numInstances = option("--instances").isEmpty() ? 32 : juce::jmax(1, option("--instances").getIntValue());
+    auto numThreads = option("--threads").isEmpty() ? juce::SystemStats::getNumCpus()
+                                                    : juce::jmax(1, option("--threads").getIntValue());
+    auto seconds = option("--seconds").isEmpty() ? 10.0 : juce::jmax(0.1, option("--seconds").getDoubleValue());
+    auto density = option("--density").isEmpty() ? 20.0 : juce::jmax(0.0, option("--density").getDoubleValue());
+    auto realtime = args.contains("--realtime");
+
+    juce::Array<int> blockSizes {64, 128, 256, 512, 1024};
+
+    if (auto list = option("--blocks"); list.isNotEmpty())
+    {
+        blockSizes.clear();
+
+        for (auto& size: juce::StringArray::fromTokens(list, ",", ""))
+            blockSizes.add(juce::jlimit(1, 8192, size.getIntValue()));
+    }
+
+    std::printf("TinTin host simulation: %d instances on %d audio thread(s), %.0f note events/s each, "
+                "%.1f s per buffer size%s\n\n",
+                numInstances,
+                numThreads,
+                density,
+                seconds,
+                realtime ? ", paced in real time" : "");
+
+    // a session's worth of differently set up instances
+    std::vector<std::unique_ptr<Instance>> instances;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        auto instance = std::make_unique<Instance>();
+        instance->random.setSeed(i + 1);
+        instance->playHead.bpm = 80.0 + 10.0 * (i % 8);
+        instance->processor.setPlayHead(&instance->playHead);
+
+        auto& params = instance->processor.getParams();
+        *params.modeSelect = 1 + i % 5;
+        *params.scaleSelect = i % 10;
+        *params.displacementMode = i % 3;
+        *params.displacementSync = i % 16;
+
+        // starts converting the samples to the rate
+        instance->processor.setRateAndBufferSizeDetails(sampleRate, blockSizes[0]);
+        instance->processor.prepareToPlay(sampleRate, blockSizes[0]);
+
+        instances.push_back(std::move(instance));
+    }
+
+    // every instance plays the one shared set of samples, loaded in the background
+    auto loaded = [](const std::unique_ptr<Instance>& i)
+    {
+        return i->processor.isSampleSetReady() && ! i->processor.isLoadingSamples();
+    };
+
+    for (int waited = 0; ! std::all_of(instances.begin(), instances.end(), loaded) && waited < 60000; waited += 10)
+        juce::Thread::sleep(10);
+
+    for (auto blockSize: blockSizes)
+        run(instances, numThreads, blockSize, seconds, density, realtime);
+
+    for (auto& instance: instances)
+        instance->processor.setPlayHead(nullptr);
+
+    return 0;
+}
@@ -0,0 +1,195 @@
+// Benchmarks/UIBenchmark.cpp
+// Renders the editor and piano view offscreen into a juce::Image and reports
+// per-frame paint times. Needs no display, so it runs on a headless Linux box.
+//
+// usage: TinTinUIBenchmark [frames]
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+#include <algorithm>
+#include <cstdio>
+
+struct FrameTimes
+{
+    std::vector<double> ms;
+
+    template <typename Fn>
+    void measure(int frames, Fn&& fn)
+    {
+        ms.clear();
+        ms.reserve((size_t) frames);
+
+        for (int i = 0; i < frames; ++i)
+        {
+            auto start = juce::Time::getHighResolutionTicks();
+            fn();
+            auto end = juce::Time::getHighResolutionTicks();
+
+            ms.push_back(juce::Time::highResolutionTicksToSeconds(end - start) * 1000.0);
+        }
+    }
+
+    double percentile(double p) const
+    {
+        if (ms.empty())
+            return 0.0;
+
+        auto sorted = ms;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto index = (size_t) std::round(p * (double) (sorted.size() - 1));
+        return sorted[index];
+    }
+
+    void print(const char* stage, const juce::String& config) const
+    {
+        std::printf("%-22s %-26s p50 %8.4f  p90 %8.4f  p99 %8.4f  max %8.4f ms\n",
+                    stage,
+                    config.toRawUTF8(),
+                    percentile(0.5),
+                    percentile(0.9),
+                    percentile(0.99),
+                    percentile(1.0));
+    }
+};
+
+struct TintinUIBenchmark
+{
+    static constexpr int firstKey = 60; // TintinPianoView shows C4..B5
+    static constexpr int numKeys = 24;
+
+    // every n-th key lit in each layer, offset per layer so stripes overlap realistically
+    static void setDensity(TintinPianoView& view, float density)
+    {
+        std::vector<int> staticT;
+        std::array<bool, 128> m {};
+        std::array<bool, 128> t {};
+
+        auto lit = (int) std::round(density * (float) numKeys);
+
+        for (int i = 0; i < lit; ++i)
+        {
+            staticT.push_back(firstKey + i);
+            m[(size_t) (firstKey + (i * 7) % numKeys)] = true;
+            t[(size_t) (firstKey + (i * 5 + 3) % numKeys)] = true;
+        }
+
+        view.setStaticTNotes(staticT);
+        view.setMVoiceState(m);
+        view.setTVoiceState(t);
+    }
+
+    static void runPiano(int frames)
+    {
+        TintinPianoView view;
+
+        const std::pair<int, int> sizes[] = {{300, 120}, {514, 188}, {1200, 400}};
+        const float densities[] = {0.0f, 0.25f, 0.5f, 1.0f};
+
+        for (auto [w, h]: sizes)
+        {
+            view.setSize(w, h);
+
+            juce::Image image(juce::Image::ARGB, w, h, true);
+            juce::Graphics g(image);
+            auto bounds = view.getLocalBounds().toFloat();
+
+            for (auto density: densities)
+            {
+                setDensity(view, density);
+
+                auto config = juce::String(w) + "x" + juce::String(h) + " density "
+                              + juce::String(density, 2);
+
+                FrameTimes times;
+
+                times.measure(frames, [&] { view.paint(g); });
+                times.print("TintinPianoView::paint", config);
+
+                times.measure(frames, [&] { view.paintBasePiano(g, bounds); });
+                times.print("paintBasePiano", config);
+
+                times.measure(frames, [&] { view.paintHighlights(g, bounds); });
+                times.print("paintHighlights", config);
+            }
+        }
+    }
+
+    static void runEditor(int frames)
+    {
+        TinTinProcessor processor;
+        TinTinProcessorEditor editor(processor);
+
+        const std::pair<int, int> sizes[] = {{800, 446}, {1200, 669}, {1600, 892}};
+
+        for (auto [w, h]: sizes)
+        {
+            editor.setSize(w, h);
+
+            juce::Image image(juce::Image::ARGB, w, h, true);
+            juce::Graphics g(image);
+
+            auto config = juce::String(w) + "x" + juce::String(h);
+
+            FrameTimes times;
+
+            times.measure(frames, [&] { editor.paint(g); });
+            times.print("Editor::paint", config);
+
+            // the whole tree: background, every button and both piano views
+            times.measure(frames, [&] { editor.paintEntireComponent(g, true); });
+            times.print("Editor (all children)", config);
+        }
+    }
+
+    static void runButtons(int frames)
+    {
+        TintinLookAndFeel lf;
+        juce::TextButton button {"1st Position Superior"};
+        button.setLookAndFeel(&lf);
+
+        const std::pair<int, int> sizes[] = {{40, 22}, {280, 26}, {560, 52}};
+
+        for (auto [w, h]: sizes)
+        {
+            button.setSize(w, h);
+
+            juce::Image image(juce::Image::ARGB, w, h, true);
+            juce::Graphics g(image);
+
+            auto colour = lf.findColour(juce::TextButton::buttonColourId);
+
+            for (auto on: {false, true})
+            {
+                button.setToggleState(on, juce::dontSendNotification);
+
+                auto config = juce::String(w) + "x" + juce::String(h)
+                              + (on ? " on" : " off");
+
+                FrameTimes times;
+                times.measure(frames,
+                              [&] { lf.drawButtonBackground(g, button, colour, false, false); });
+                times.print("drawButtonBackground", config);
+            }
+        }
+
+        button.setLookAndFeel(nullptr);
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI gui;
+
+    auto frames = argc > 1 ? juce::jmax(1, juce::String(argv[1]).getIntValue()) : 500;
+
+    std::printf("TinTin UI benchmark, %d frames per configuration\n\n", frames);
+
+    TintinUIBenchmark::runPiano(frames);
+    std::printf("\n");
+    TintinUIBenchmark::runEditor(frames);
+    std::printf("\n");
+    TintinUIBenchmark::runButtons(frames);
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Benchmarks/VoiceBenchmark.cpp
+// Compares the stock juce::SamplerVoice path with TintinSamplerVoice (vector kernels)
+// at 8, 32 and 128 simultaneously sounding voices, and the same voices inside the
+// full 128 voice TintinSynth pool. Then the cost of each interpolation tier
+// (see TintinVoiceKernels::Interpolation) at 32 voices.
+//
+// usage: TinTinVoiceBenchmark [seconds of audio per run]
+#include "TintinSynth.h"
+
+#include <cstdio>
+#include <utility>
+
+static constexpr double sampleRate = 48000.0;
+static constexpr int blockSize = 512;
+
+// a 10 second stereo test tone written to memory as a WAV, so both sound types
+// are built from a real AudioFormatReader like in the plugin
+static juce::MemoryBlock makeTestWav()
+{
+    juce::AudioBuffer<float> tone(2, (int) (10.0 * sampleRate));
+    juce::Random random(1234);
+
+    for (int i = 0; i < tone.getNumSamples(); ++i)
+    {
+        auto t = (double) i / sampleRate;
+        auto decay = (float) std::exp(-t * 0.4);
+
+        tone.setSample(0, i, decay * (float) std::sin(juce::MathConstants<double>::twoPi * 261.6 * t));
+        tone.setSample(1, i, decay * (0.5f * random.nextFloat() - 0.25f));
+    }
+
+    juce::MemoryBlock wav;
+    juce::WavAudioFormat format;
+
+    {
+        auto stream = std::make_unique<juce::MemoryOutputStream>(wav, false);
+        std::unique_ptr<juce::AudioFormatWriter> writer(
+            format.createWriterFor(stream.get(), sampleRate, 2, 16, {}, 0));
+
+        if (writer != nullptr)
+        {
+            stream.release(); // the writer owns it now
+            writer->writeFromAudioSampleBuffer(tone, 0, tone.getNumSamples());
+        }
+    }
+
+    return wav;
+}
+
+static std::unique_ptr<juce::AudioFormatReader> makeReader(const juce::MemoryBlock& wav)
+{
+    juce::WavAudioFormat format;
+    return std::unique_ptr<juce::AudioFormatReader>(format.createReaderFor(
+        new juce::MemoryInputStream(wav, false), true));
+}
+
+// keeps numVoices notes sounding for the whole run and returns seconds spent rendering
+static double run(juce::Synthesiser& synth, int numVoices, double seconds)
+{
+    synth.setCurrentPlaybackSampleRate(sampleRate);
+
+    juce::AudioBuffer<float> out(2, blockSize);
+    juce::MidiBuffer midi;
+
+    // distinct (channel, note) pairs so the synth never retriggers a sounding voice
+    for (int i = 0; i < numVoices; ++i)
+        midi.addEvent(juce::MidiMessage::noteOn(1 + i / 40, 40 + i % 40, 0.8f), 0);
+
+    auto numBlocks = (int) (seconds * sampleRate / blockSize);
+    auto start = juce::Time::getHighResolutionTicks();
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        out.clear();
+        synth.renderNextBlock(out, midi, 0, blockSize);
+        midi.clear();
+    }
+
+    auto elapsed = juce::Time::getHighResolutionTicks() - start;
+    synth.allNotesOff(0, false);
+
+    return juce::Time::highResolutionTicksToSeconds(elapsed);
+}
+
+static void report(const char* name, int numVoices, double seconds, double elapsed)
+{
+    auto voiceSamples = (double) numVoices * seconds * sampleRate;
+
+    std::printf("%-26s %4d voices  %8.2f ns/voice-sample  %8.1fx realtime\n",
+                name,
+                numVoices,
+                elapsed * 1.0e9 / voiceSamples,
+                seconds / elapsed);
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    auto seconds = argc > 1 ? juce::jmax(0.5, juce::String(argv[1]).getDoubleValue()) : 4.0;
+    auto wav = makeTestWav();
+
+    std::printf("TinTin voice benchmark, %.1f s per run, block %d, kernel: %s\n\n",
+                seconds,
+                blockSize,
+                TintinVoiceKernels::getKernelName());
+
+    for (auto numVoices: {8, 32, 128})
+    {
+        {
+            juce::Synthesiser synth;
+
+            for (int i = 0; i < numVoices; ++i)
+                synth.addVoice(new juce::SamplerVoice());
+
+            juce::BigInteger allNotes;
+            allNotes.setRange(0, 128, true);
+
+            auto reader = makeReader(wav);
+            synth.addSound(new juce::SamplerSound("test", *reader, allNotes, 60, 0.0, 0.2, 10.0));
+
+            report("juce::SamplerVoice", numVoices, seconds, run(synth, numVoices, seconds));
+        }
+
+        {
+            juce::Synthesiser synth;
+
+            for (int i = 0; i < numVoices; ++i)
+                synth.addVoice(new TintinSamplerVoice());
+
+            auto reader = makeReader(wav);
+            synth.addSound(new TintinSamplerSound(*reader, TintinKeyZone {}, 0.0, 0.2, 10.0));
+
+            report("TintinSamplerVoice", numVoices, seconds, run(synth, numVoices, seconds));
+        }
+
+        {
+            TintinSynth synth;
+            synth.setVoiceLimit(numVoices);
+
+            auto reader = makeReader(wav);
+            synth.addSound(new TintinSamplerSound(*reader, TintinKeyZone {}, 0.0, 0.2, 10.0));
+
+            report("TintinSynth (128 pool)", numVoices, seconds, run(synth, numVoices, seconds));
+        }
+    }
+
+    std::printf("\n");
+
+    using Interpolation = TintinVoiceKernels::Interpolation;
+
+    for (auto [interpolation, name]: {std::pair {Interpolation::linear, "Draft (linear)"},
+                                      std::pair {Interpolation::cubic, "Cubic"},
+                                      std::pair {Interpolation::sinc, "Sinc"}})
+    {
+        TintinSynth synth;
+        synth.setVoiceLimit(32);
+        synth.setInterpolation(interpolation);
+
+        auto reader = makeReader(wav);
+        synth.addSound(new TintinSamplerSound(*reader, TintinKeyZone {}, 0.0, 0.2, 10.0));
+
+        report(name, 32, seconds, run(synth, 32, seconds));
+    }
+
+    return 0;
+}
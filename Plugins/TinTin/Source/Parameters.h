@@ -3,7 +3,10 @@
 
 #include <shared_plugin_helpers/shared_plugin_helpers.h>
 
-#pragma once
+// 0 in the MIDI effect build (TinTinMidi), which has no sampler and none of its parameters
+#ifndef TINTIN_WITH_SAMPLER
+    #define TINTIN_WITH_SAMPLER 1
+#endif
 
 struct Parameters
 {
@@ -21,6 +24,11 @@ struct Parameters
         static constexpr auto velFixed   = "velFixed";
         static constexpr auto scale      = "scale";
         static constexpr auto mVoice   = "mvoice";
+        static constexpr auto sampler  = "sampler";
+        static constexpr auto voices   = "voices";
+        static constexpr auto liveQuality   = "liveQuality";
+        static constexpr auto renderQuality = "renderQuality";
+        static constexpr auto parallel      = "parallel";
     };
 
     void add(juce::AudioProcessor& p) const
@@ -37,6 +45,13 @@ struct Parameters
         p.addParameter(fixedVelocityParam);
         p.addParameter(scaleSelect);
         p.addParameter(mVoiceOn);
+#if TINTIN_WITH_SAMPLER
+        p.addParameter(samplerOn);
+        p.addParameter(polyphony);
+        p.addParameter(liveQuality);
+        p.addParameter(renderQuality);
+        p.addParameter(parallelVoices);
+#endif
     }
 
     juce::AudioParameterInt* rootNote =
@@ -103,4 +118,33 @@ struct Parameters
     juce::AudioParameterBool* mVoiceOn =
     new juce::AudioParameterBool({ IDs::mVoice, 1 }, "M Voice Heard", true);
 
+#if TINTIN_WITH_SAMPLER
+    // off leaves the plugin a MIDI generator: nothing is rendered and the voices stop
+    juce::AudioParameterBool* samplerOn =
+        new juce::AudioParameterBool({ IDs::sampler, 1 }, "Sampler", true);
+
+    // voices the sampler may use at once, 128 is the size of the preallocated pool
+    juce::AudioParameterInt* polyphony =
+        new juce::AudioParameterInt({ IDs::voices, 1 }, "Polyphony",
+                                    1, 128, 32);
+
+    // sampler interpolation while playing live and while the host renders offline,
+    // in the order of TintinVoiceKernels::Interpolation
+    juce::AudioParameterChoice* liveQuality =
+        new juce::AudioParameterChoice({ IDs::liveQuality, 1 }, "Live Quality",
+                                       juce::StringArray{ "Draft", "Cubic", "Sinc" }, 1);
+
+    juce::AudioParameterChoice* renderQuality =
+        new juce::AudioParameterChoice({ IDs::renderQuality, 1 }, "Render Quality",
+                                       juce::StringArray{ "Draft", "Cubic", "Sinc" }, 2);
+
+    // voices from which the sampler renders on all cores while playing live, 0 = never.
+    // The audio thread waits on the worker threads then, so it is only for hosts with
+    // headroom to spare, and it takes effect from the next prepareToPlay if it was 0
+    // there. Offline renders always do
+    juce::AudioParameterInt* parallelVoices =
+        new juce::AudioParameterInt({ IDs::parallel, 1 }, "Parallel Voices",
+                                    0, 128, 0);
+#endif
+
 };
@@ -326,6 +326,177 @@ int TintinPianoView::midiFromPosition (float x) const
     return whiteMidi[whiteIndex];
 }
 
+TintinNoteRollView::TintinNoteRollView (TintinNoteHistory& historyToUse)
+    : history (historyToUse)
+{
+    for (auto& voice : heldSince)
+        voice.fill (-1);
+
+    lastEpoch = history.getEpoch();
+    setInterceptsMouseClicks (false, false);
+}
+
+void TintinNoteRollView::resized()
+{
+    roll = juce::Image (juce::Image::RGB,
+                        juce::jmax (1, getWidth()),
+                        juce::jmax (1, getHeight()),
+                        false);
+
+    samplesPerPixel = 0.0; // forces a restart on the next update
+    clearRoll();
+}
+
+void TintinNoteRollView::clearRoll()
+{
+    if (roll.isNull())
+        return;
+
+    juce::Graphics g (roll);
+    g.fillAll (juce::Colour (0xff202020));
+
+    // keep notes that are still held, they continue from the right edge
+    for (auto& voice : heldSince)
+        for (auto& start : voice)
+            if (start >= 0)
+                start = lastColumn;
+}
+
+float TintinNoteRollView::noteToY (int note) const
+{
+    auto rowH = (float) roll.getHeight() / (float) (highestNote - lowestNote + 1);
+    return (float) (highestNote - note) * rowH;
+}
+
+void TintinNoteRollView::drawSpan (juce::Graphics& g,
+                                   int note,
+                                   int voice,
+                                   juce::int64 startColumn,
+                                   juce::int64 endColumn) const
+{
+    if (note < lowestNote || note > highestNote)
+        return;
+
+    auto width = (juce::int64) roll.getWidth();
+    auto x1    = width - 1 - (lastColumn - startColumn);
+    auto x2    = width - (lastColumn - endColumn);
+
+    if (x2 <= 0 || x1 >= width)
+        return;
+
+    x1 = juce::jmax ((juce::int64) 0, x1);
+    x2 = juce::jmin (width, juce::jmax (x1 + 1, x2));
+
+    auto rowH = (float) roll.getHeight() / (float) (highestNote - lowestNote + 1);
+
+    // opaque colours so redrawing a column is idempotent
+    g.setColour (voice == TintinNoteEvent::M ? juce::Colours::steelblue
+                                             : juce::Colours::red);
+    g.fillRect (juce::Rectangle<float> ((float) x1,
+                                        noteToY (note),
+                                        (float) (x2 - x1),
+                                        juce::jmax (1.0f, rowH - 1.0f)));
+}
+
+void TintinNoteRollView::update (double sampleRate)
+{
+    if (roll.isNull() || sampleRate <= 0.0)
+        return;
+
+    auto epoch = history.getEpoch();
+    auto spp   = visibleSeconds * sampleRate / (double) roll.getWidth();
+    auto now   = history.getLatestTimestamp();
+
+    if (epoch != lastEpoch)
+    {
+        for (auto& voice : heldSince)
+            voice.fill (-1);
+
+        lastEpoch       = epoch;
+        samplesPerPixel = 0.0;
+    }
+
+    auto nowColumn = (juce::int64) ((double) now / spp);
+
+    if (spp != samplesPerPixel || nowColumn < lastColumn)
+    {
+        samplesPerPixel = spp;
+        lastColumn      = nowColumn;
+        clearRoll();
+    }
+
+    auto prevColumn = lastColumn;
+    auto shift      = nowColumn - prevColumn;
+    auto width      = roll.getWidth();
+
+    if (shift > 0 && shift < width)
+        roll.moveImageSection (0, 0, (int) shift, 0, width - (int) shift, roll.getHeight());
+
+    juce::Graphics g (roll);
+
+    if (shift > 0)
+    {
+        g.setColour (juce::Colour (0xff202020));
+        g.fillRect (juce::jmax (0, width - (int) shift), 0,
+                    juce::jmin (width, (int) shift), roll.getHeight());
+    }
+
+    lastColumn = nowColumn;
+
+    for (;;)
+    {
+        auto numRead = history.pop (scratch.data(), maxEventsPerUpdate);
+
+        for (int i = 0; i < numRead; ++i)
+        {
+            const auto& e = scratch[(size_t) i];
+
+            auto  column = juce::jmin (nowColumn, (juce::int64) ((double) e.timestamp / spp));
+            auto& held   = heldSince[(size_t) (e.voice & 1)][(size_t) (e.note & 127)];
+
+            if (held >= 0)
+                drawSpan (g, e.note, e.voice, juce::jmax (held, prevColumn), column);
+
+            held = e.velocity > 0 ? column : -1;
+        }
+
+        if (numRead < maxEventsPerUpdate)
+            break;
+    }
+
+    for (int voice = 0; voice < 2; ++voice)
+    {
+        for (int note = 0; note < 128; ++note)
+        {
+            auto held = heldSince[(size_t) voice][(size_t) note];
+
+            if (held >= 0)
+                drawSpan (g, note, voice, juce::jmax (held, prevColumn), nowColumn);
+        }
+    }
+
+    repaint();
+}
+
+void TintinNoteRollView::paint (juce::Graphics& g)
+{
+    using namespace juce;
+
+    g.drawImageAt (roll, 0, 0);
+
+    g.setColour (Colours::black.withAlpha (0.4f));
+    g.drawRect (getLocalBounds().toFloat(), 1.0f);
+
+    if (auto dropped = history.getNumDropped(); dropped > 0)
+    {
+        g.setColour (Colours::orange);
+        g.setFont (Font (12.0f));
+        g.drawText ("dropped: " + String (dropped),
+                    getLocalBounds().reduced (4).removeFromTop (14),
+                    Justification::topRight);
+    }
+}
+
 
 int TinTinProcessorEditor::midiRootFromIndex (int index)
 {
@@ -374,11 +545,13 @@ int TinTinProcessorEditor::positionButtonFromModeIndex (int modeIndex)
 TinTinProcessorEditor::TinTinProcessorEditor (TinTinProcessor& p)
     : AudioProcessorEditor (&p),
       processor (p),
-      lf()
+      lf(),
+      noteRoll (p.getNoteHistory())
 {
     setLookAndFeel (&lf);
 
     addAndMakeVisible (pianoView);
+    addAndMakeVisible (noteRoll);
 
     pianoView.setNoteCallback ([this] (int midi, bool isDown)
     {
@@ -386,7 +559,7 @@ TinTinProcessorEditor::TinTinProcessorEditor (TinTinProcessor& p)
     });
 
     addAndMakeVisible (titleLabel);
-    titleLabel.setText ("Tintinnabulator v1.3", juce::dontSendNotification);
+    updateTitle();
     titleLabel.setJustificationType (juce::Justification::centredLeft);
     titleLabel.setFont (juce::Font (26.0f, juce::Font::bold));
 
@@ -407,7 +580,7 @@ TinTinProcessorEditor::TinTinProcessorEditor (TinTinProcessor& p)
         processor.getParams().displacementMs->setValueNotifyingHost (value);
     };
 
-    setSize (800, 320);
+    setSize (800, 320 + rollHeight + pad);
 
     syncFromParams();
     syncPianoFromProcessor();
@@ -423,15 +596,10 @@ TinTinProcessorEditor::~TinTinProcessorEditor()
 
 void TinTinProcessorEditor::handlePianoNote (int midiNote, bool isDown)
 {
-    auto& state = processor.getPreviewKeyboardState();
-
     constexpr int   channel  = 1;
     constexpr float velocity = 0.8f;
 
-    if (isDown)
-        state.noteOn  (channel, midiNote, velocity);
-    else
-        state.noteOff (channel, midiNote, velocity);
+    processor.getPreviewNotes().push (channel, midiNote, velocity, isDown);
 }
 
 
@@ -572,9 +740,35 @@ void TinTinProcessorEditor::initDelayButtons()
     };
 }
 
+void TinTinProcessorEditor::updateTitle()
+{
+    samplesShownReady = processor.isSampleSetReady();
+    underrunsShown    = processor.getNumStreamUnderruns();
+    sampleErrorShown  = processor.getSampleLoadError();
+
+    juce::String title ("Tintinnabulator v1.3");
+
+    if (! TinTinProcessor::hasSampler)
+        title << " (MIDI)";
+    else if (sampleErrorShown.isNotEmpty())
+        title << " (" << sampleErrorShown << ")";
+    else if (! samplesShownReady)
+        title << " (loading...)";
+    else if (underrunsShown > 0)
+        title << " (" << (int) underrunsShown << " disk underruns)";
+
+    titleLabel.setText (title, juce::dontSendNotification);
+}
+
 void TinTinProcessorEditor::timerCallback()
 {
+    if (samplesShownReady != processor.isSampleSetReady()
+        || underrunsShown != processor.getNumStreamUnderruns()
+        || sampleErrorShown != processor.getSampleLoadError())
+        updateTitle();
+
     syncPianoFromProcessor();
+    noteRoll.update (processor.getSampleRate());
 }
 
 void TinTinProcessorEditor::syncPianoFromProcessor()
@@ -912,6 +1106,11 @@ void TinTinProcessorEditor::resized()
         msSlider.setBounds (delayRow.reduced (1));
     }
 
+    right.removeFromTop (pad);
+
+    // note history under the delay row
+    noteRoll.setBounds (right.removeFromTop (rollHeight).reduced (pad, 0));
+
     // putting controls above the piano?!
     for (auto& b : rootButtons) b.toFront (false);
     majorButton.toFront (false);
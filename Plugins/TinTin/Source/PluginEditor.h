@@ -5,6 +5,7 @@
 #include <functional>
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_gui_basics/juce_gui_basics.h>
+#include "TintinNoteHistory.h"
 // #include "PluginProcessor.h"
 
 
@@ -76,6 +77,9 @@ private:
                      float yOffsetFraction,
                      const juce::Colour& colour) const;
 
+    // lets the headless UI benchmark time the paint stages individually
+    friend struct TintinUIBenchmark;
+
     NoteCallback noteCallback;
 
     std::array<bool, 128> staticTNotes{}; // gold (all allowed)
@@ -85,6 +89,48 @@ private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TintinPianoView)
 };
 
+// scrolling M/T note history, drawn incrementally into a cached image:
+// each update shifts the image left and only paints the newly exposed columns
+class TintinNoteRollView : public juce::Component
+{
+public:
+    explicit TintinNoteRollView (TintinNoteHistory& historyToUse);
+
+    // called from the editor timer with the current processor sample rate
+    void update (double sampleRate);
+
+    void paint   (juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    static constexpr int    lowestNote     = 21;  // A0
+    static constexpr int    highestNote    = 108; // C8
+    static constexpr double visibleSeconds = 8.0;
+    static constexpr int    maxEventsPerUpdate = 512;
+
+    void  clearRoll();
+    float noteToY (int note) const;
+    void  drawSpan (juce::Graphics& g,
+                    int note,
+                    int voice,
+                    juce::int64 startColumn,
+                    juce::int64 endColumn) const;
+
+    TintinNoteHistory& history;
+
+    juce::Image roll;
+    double samplesPerPixel = 0.0;
+    juce::int64 lastColumn = 0;
+    uint32_t lastEpoch     = 0;
+
+    // start column of currently held notes per voice, -1 = not held
+    std::array<std::array<juce::int64, 128>, 2> heldSince {};
+
+    std::array<TintinNoteEvent, maxEventsPerUpdate> scratch {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TintinNoteRollView)
+};
+
 class TinTinProcessorEditor : public juce::AudioProcessorEditor
     , private juce::Timer
 {
@@ -110,6 +156,7 @@ private:
 
     void syncFromParams();
     void syncPianoFromProcessor();
+    void updateTitle();
 
     void selectRoot      (int index);
     void selectTriad     (bool isMajor);
@@ -132,11 +179,15 @@ private:
     static constexpr int smallH   = 22;
     static constexpr int leftWidth = 280;
     static constexpr int pianoHeight = 200;
+    static constexpr int rollHeight  = 120;
 
     TinTinProcessor& processor;
     TintinLookAndFeel lf;
 
     int rootIndexUI = 0;
+    bool samplesShownReady = false;
+    uint32_t underrunsShown = 0;
+    juce::String sampleErrorShown;
 
     juce::Label titleLabel;
 
@@ -154,6 +205,7 @@ private:
     juce::TextButton mVoiceButton { "M-Voice Heard" };
 
     TintinPianoView pianoView;
+    TintinNoteRollView noteRoll;
 
     juce::TextButton tHighlightButton  { "" };
     juce::TextButton orbitToggleButton { "\u00B1" };
@@ -3,68 +3,184 @@
 #include "PluginEditor.h"
 
 TinTinProcessor::TinTinProcessor()
+#if TINTIN_WITH_SAMPLER
+    : ProcessorBase (BusesProperties()
+                         .withOutput ("M", juce::AudioChannelSet::stereo(), true)
+                         .withOutput ("T", juce::AudioChannelSet::stereo(), false))
+#else
+    : ProcessorBase (BusesProperties()) // a MIDI effect has no audio buses
+#endif
 {
     params.add (*this);
 
-    // synth
-    piano.clearVoices();
-    for (int i = 0; i < 8; ++i)
-        piano.addVoice (new juce::SamplerVoice());
+    for (auto* parameter : getParameters())
+        parameter->addListener (&optionsWatcher);
 
-    formatManager.registerBasicFormats();
-    loadPianoSound();
+#if TINTIN_WITH_SAMPLER
+    // synth, TintinSynth preallocates its voice pool and gets its sounds
+    // from the background loader, see onSoundsLoaded(). Sets it converts to the
+    // session rate are kept in the user's cache folder for the next session
+    sampleLibrary.warmCache = TintinSampleLoader::getDefaultWarmCacheFolder();
+    sampleLoader.start (sampleLibrary);
+#endif
 
     updateOptions();
+
+    auto captureFolder = juce::SystemStats::getEnvironmentVariable ("TINTIN_CAPTURE_FOLDER", {});
+
+    if (captureFolder.isNotEmpty() && juce::File::isAbsolutePath (captureFolder))
+    {
+        juce::File folder (captureFolder);
+        folder.createDirectory();
+        startSessionCapture (folder.getNonexistentChildFile ("tintin", ".tintinsession"));
+    }
 }
 
-void TinTinProcessor::loadSample(const void* data,
-                                 int dataSize,
-                                 int rootMidiNote)
-{
-    auto input = std::make_unique<juce::MemoryInputStream>(data, dataSize, false);
+#if TINTIN_WITH_SAMPLER
 
-    if (auto* reader = formatManager.createReaderFor(std::move(input)))
+void TinTinProcessor::onSoundsLoaded (TintinSoundSet::Ptr sounds, const TintinSampleLoader::Library& library)
+{
+    if (sounds == nullptr)
     {
-        juce::BigInteger notes;
-        notes.setRange(0, 128, true);
+        const juce::ScopedLock sl (libraryLock);
 
-        auto* sound = new juce::SamplerSound(
-            "IntimateSample",
-            *reader,
-            notes,
-            rootMidiNote,
-            0.0,   // attack
-            0.2,   // release
-            10.0   // max length
-        );
+        // a library asked for since is loaded next and decides for itself
+        if (library.folder != sampleLibrary.folder || library.preloadFrames != sampleLibrary.preloadFrames)
+            return;
 
-        piano.addSound(sound);
+        sampleLoadError = library.folder == juce::File() ? juce::String ("couldn't load the piano samples")
+                                                         : "couldn't load " + library.folder.getFileName();
+        DBG("Could not load " << library.folder.getFullPathName());
+
+        // the state saves what actually plays: the set before, or the embedded piano
+        if (pianoSounds != nullptr)
+        {
+            sampleLibrary.folder        = playingLibrary.folder;
+            sampleLibrary.preloadFrames = playingLibrary.preloadFrames;
+        }
+        else if (library.folder != juce::File())
+        {
+            sampleLibrary.folder        = juce::File();
+            sampleLibrary.preloadFrames = TintinSampleLoader::defaultPreloadFrames;
+            sampleLoader.start (sampleLibrary);
+        }
+
+        return;
     }
-    else
+
+    if (sounds->isStreamed())
     {
-        DBG("Reader = nullptr (could not read sample!)");
+        mPiano.prepareStreaming();
+        tPiano.prepareStreaming();
     }
+
+    releaseSeconds = sounds->getLongestRelease();
+
+    auto generation = soundGeneration.load() + 1;
+
+    if (pianoSounds != nullptr)
+        retiredSounds.emplace_back (pianoSounds, generation);
+
+    pianoSounds = sounds;
+    mPiano.setSoundSet (pianoSounds.get());
+    tPiano.setSoundSet (pianoSounds.get());
+    soundGeneration.store (generation, std::memory_order_release);
+
+    const juce::ScopedLock sl (libraryLock);
+    playingLibrary = library;
+}
+
+bool TinTinProcessor::freeRetiredSounds()
+{
+    // only the sets every block since has been past. A voice still playing or fading
+    // out one of their sounds holds a reference to it, and those are only ever
+    // dropped by the voices, never taken again
+    auto seen = audioGeneration.load (std::memory_order_acquire);
+
+    retiredSounds.erase (std::remove_if (retiredSounds.begin(),
+                                         retiredSounds.end(),
+                                         [seen] (const auto& retired)
+                                         {
+                                             return retired.second <= seen && ! retired.first->isInUse();
+                                         }),
+                         retiredSounds.end());
+
+    return ! retiredSounds.empty();
+}
+
+void TinTinProcessor::acknowledgeSoundSet() noexcept
+{
+    // from here on this thread only reaches sets installed at this generation or later
+    audioGeneration.store (soundGeneration.load (std::memory_order_acquire), std::memory_order_release);
+}
+
+void TinTinProcessor::setSampleLibrary (const juce::File& folder, int preloadFrames)
+{
+    // starting under the lock keeps the loader's requests in the order sampleLibrary
+    // changed, a failed load falling back to the embedded piano included
+    const juce::ScopedLock sl (libraryLock);
+
+    sampleLibrary.folder        = folder;
+    sampleLibrary.preloadFrames = juce::jmax (256, preloadFrames);
+    sampleLoadError             = {};
+
+    sampleLoader.start (sampleLibrary);
 }
 
-void TinTinProcessor::loadPianoSound()
+TintinSampleLoader::Library TinTinProcessor::getSampleLibrary() const
 {
-    DBG("C4 size = " << BinaryData::C4_wavSize);
-    DBG("Fs3 size = " << BinaryData::Fs4_wavSize);
-    DBG("A2 size = " << BinaryData::A2_wavSize);
+    const juce::ScopedLock sl (libraryLock);
+    return sampleLibrary;
+}
 
-    loadSample(BinaryData::C4_wav,  BinaryData::C4_wavSize, 60); // C4
-    loadSample(BinaryData::Fs4_wav, BinaryData::Fs4_wavSize, 54); // F#3
-    loadSample(BinaryData::A2_wav,  BinaryData::A2_wavSize, 45); // A2
+juce::String TinTinProcessor::getSampleLoadError() const
+{
+    const juce::ScopedLock sl (libraryLock);
+    return sampleLoadError;
 }
+#endif
 
 void TinTinProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    DBG("Voices: " << piano.getNumVoices());
-    DBG("Sounds: " << piano.getNumSounds());
+#if TINTIN_WITH_SAMPLER
+    DBG("Voices: " << mPiano.getNumVoices() << " + " << tPiano.getNumVoices());
+    DBG("Samples ready: " << (isSampleSetReady() ? "yes" : "no"));
+
+    mPiano.setCurrentPlaybackSampleRate (sampleRate);
+    tPiano.setCurrentPlaybackSampleRate (sampleRate);
+
+    // the loader converts the samples to this rate in the background (cached per
+    // rate across instances); until then the current set keeps playing at the right pitch
+    {
+        const juce::ScopedLock sl (libraryLock);
+
+        if (! juce::approximatelyEqual (sampleLibrary.playbackRate, sampleRate))
+        {
+            sampleLibrary.playbackRate = sampleRate;
+            sampleLoader.start (sampleLibrary);
+        }
+    }
+
+    tMidi.ensureSize (8192);
+    acknowledgeSoundSet(); // nothing renders while preparing
+
+    // buffers for rendering on the worker pool: always for a bounce, live only when
+    // asked for. Blocks with more voices than the polyphony render serially
+    if (isNonRealtime() || params.parallelVoices->get() > 0)
+    {
+        mPiano.prepareParallel (samplesPerBlock, params.polyphony->get());
+        tPiano.prepareParallel (samplesPerBlock, params.polyphony->get());
+    }
+#endif
 
-    juce::ignoreUnused (samplesPerBlock);
-    piano.setCurrentPlaybackSampleRate (sampleRate);
     tintin.resetOrbit();
+    tintin.prepare();
+    inputCopy.ensureSize (8192);
+    sessionRecorder.capturePrepare (sampleRate, samplesPerBlock);
+    juce::ignoreUnused (sampleRate, samplesPerBlock);
+
+    historyPosition = 0;
+    noteHistory.reset();
     updateOptions();
 }
 
@@ -117,6 +233,34 @@ void TinTinProcessor::updateOptions()
     c.numTVoices      = 1;   //for v2
     c.mVoiceOn        = params.mVoiceOn->get();
 
+    displacementSeconds = TintinMapper::getLatestEventSeconds (c);
+
+#if TINTIN_WITH_SAMPLER
+    // switched off: what is still sounding stops here, as it won't be rendered
+    // again to fade out, and nothing from before plays when it's back on
+    const bool wasOn = std::exchange (samplerOn, params.samplerOn->get());
+
+    if (wasOn && ! samplerOn)
+    {
+        mPiano.reset();
+        tPiano.reset();
+    }
+
+    mPiano.setVoiceLimit (params.polyphony->get());
+    tPiano.setVoiceLimit (params.polyphony->get());
+
+    // a bounce can spend more on interpolation than a live session
+    auto* quality = isNonRealtime() ? params.renderQuality : params.liveQuality;
+    auto interpolation = static_cast<TintinVoiceKernels::Interpolation> (quality->getIndex());
+    mPiano.setInterpolation (interpolation);
+    tPiano.setInterpolation (interpolation);
+
+    // the output is the same either way, a bounce spreads dense passages over the cores
+    auto parallelThreshold = isNonRealtime() ? 2 : params.parallelVoices->get();
+    mPiano.setParallelThreshold (parallelThreshold);
+    tPiano.setParallelThreshold (parallelThreshold);
+#endif
+
     updateStaticTGrid();
 }
 
@@ -175,23 +319,78 @@ void TinTinProcessor::updateHighlightState (const juce::MidiBuffer& mInput,
     applyBufferToFlags (tOutput, pianoHighlightState.outputT);
 }
 
+void TinTinProcessor::pushNoteHistory (const juce::MidiBuffer& mInput,
+                                       const juce::MidiBuffer& tEvents,
+                                       int numSamples)
+{
+    auto pushBuffer = [this] (const juce::MidiBuffer& src, uint8_t voice)
+    {
+        for (auto meta : src)
+        {
+            const auto& msg = meta.getMessage();
+
+            if (! msg.isNoteOnOrOff())
+                continue;
+
+            TintinNoteEvent e;
+            e.timestamp = historyPosition + meta.samplePosition;
+            e.note      = (uint8_t) msg.getNoteNumber();
+            e.velocity  = msg.isNoteOn() ? msg.getVelocity() : (uint8_t) 0;
+            e.voice     = voice;
+
+            noteHistory.push (e);
+        }
+    };
+
+    pushBuffer (mInput,  TintinNoteEvent::M);
+    pushBuffer (tEvents, TintinNoteEvent::T);
+
+    historyPosition += numSamples;
+    noteHistory.advanceTo (historyPosition);
+}
+
 void TinTinProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                     juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
     buffer.clear();
 
-    updateOptions();
+#if TINTIN_WITH_SAMPLER
+    acknowledgeSoundSet();
+#endif
+
+    // notes from the on-screen piano join the host's
+    previewNotes.popInto (midiMessages);
+
+    // what the host handed us (with the preview notes), before anything changes it
+    sessionRecorder.capture (buffer.getNumSamples(), midiMessages, getPlayHead());
+
+    // no MIDI in, no displaced notes waiting and no voice sounding: the block stays
+    // silent, only the highlights and the note history clock move on
+    bool voicesSounding = false;
+
+#if TINTIN_WITH_SAMPLER
+    voicesSounding = mPiano.getNumActiveVoices() > 0 || tPiano.getNumActiveVoices() > 0;
+#endif
+
+    if (midiMessages.isEmpty() && tintin.scheduler.isEmpty() && ! voicesSounding)
+    {
+        if (optionsWatcher.changed.exchange (false))
+            updateOptions();
+
+        const juce::MidiBuffer none;
+        updateHighlightState (none, none);
+        pushNoteHistory (none, none, buffer.getNumSamples());
+        return;
+    }
 
-    //merging on screen piano ui midi into host midi
-    //lock free?? safe??
-    previewKeyboardState.processNextMidiBuffer (midiMessages,
-                                                0,
-                                                buffer.getNumSamples(),
-                                                true);
+    optionsWatcher.changed = false;
+    updateOptions();
 
     //keep a copy of the m voice input (before tintin transforms it)
-    juce::MidiBuffer mInput (midiMessages);
+    inputCopy.clear();
+    inputCopy.addEvents (midiMessages, 0, -1, 0);
+    const auto& mInput = inputCopy;
 
     // tempo for sync displacement
     double bpm = 120.0;
@@ -207,11 +406,94 @@ void TinTinProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     tintin.process (midiMessages, getSampleRate(), buffer.getNumSamples());
 
     updateHighlightState (mInput, midiMessages);
+    pushNoteHistory (mInput, tintin.tEvents, buffer.getNumSamples());
 
-    // render from transformed midi
-    piano.renderNextBlock (buffer, midiMessages, 0, buffer.getNumSamples());
+#if TINTIN_WITH_SAMPLER
+    renderVoices (buffer, mInput);
+#endif
 }
 
+#if TINTIN_WITH_SAMPLER
+void TinTinProcessor::renderVoices (juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& mInput)
+{
+    // switched off, the voices were reset in updateOptions()
+    if (! samplerOn)
+        return;
+
+    // until the samples are loaded we're MIDI-only
+    if (! isSampleSetReady())
+        return;
+
+    // each voice group renders straight into its bus, these only refer to its channels
+    auto mOutput = getBusBuffer (buffer, false, mBus);
+    auto tOutput = getChannelCountOfBus (false, tBus) > 0 ? getBusBuffer (buffer, false, tBus) : mOutput;
+
+    // the T voices follow the input's pedal and controllers as well
+    tMidi.clear();
+
+    for (const auto meta : mInput)
+        if (! meta.getMessage().isNoteOnOrOff())
+            tMidi.addEvent (meta.getMessage(), meta.samplePosition);
+
+    tMidi.addEvents (tintin.tEvents, 0, -1, 0);
+
+    if (tintin.settings.mVoiceOn)
+    {
+        mPiano.renderNextBlock (mOutput, mInput, 0, buffer.getNumSamples());
+    }
+    else
+    {
+        // switched off with notes held: their note-offs won't come through any more,
+        // so they're released once and then left to ring out
+        if (mVoiceWasOn)
+            mPiano.allNotesOff (0, true);
+
+        if (mPiano.getNumActiveVoices() > 0)
+            mPiano.renderNextBlock (mOutput, juce::MidiBuffer(), 0, buffer.getNumSamples());
+    }
+
+    mVoiceWasOn = tintin.settings.mVoiceOn;
+
+    tPiano.renderNextBlock (tOutput, tMidi, 0, buffer.getNumSamples());
+}
+
+bool TinTinProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+    if (! layouts.inputBuses.isEmpty() && ! layouts.getMainInputChannelSet().isDisabled())
+        return false;
+
+    auto supported = [] (const juce::AudioChannelSet& set, bool mayBeDisabled)
+    {
+        return set == juce::AudioChannelSet::mono()
+               || set == juce::AudioChannelSet::stereo()
+               || (mayBeDisabled && set.isDisabled());
+    };
+
+    return layouts.outputBuses.size() == 2
+           && supported (layouts.outputBuses[mBus], false)
+           && supported (layouts.outputBuses[tBus], true);
+}
+#endif
+
+
+juce::Array<const juce::CriticalSection*> TinTinProcessor::getAudioThreadLocks() const
+{
+#if TINTIN_WITH_SAMPLER
+    return { &mPiano.getRenderLock(), &tPiano.getRenderLock() };
+#else
+    return {};
+#endif
+}
+
+double TinTinProcessor::getTailLengthSeconds() const
+{
+#if TINTIN_WITH_SAMPLER
+    if (params.samplerOn->get())
+        return displacementSeconds.load() + releaseSeconds.load();
+#endif
+
+    return displacementSeconds.load();
+}
 
 juce::AudioProcessorEditor* TinTinProcessor::createEditor()
 {
@@ -223,6 +505,16 @@ void TinTinProcessor::getStateInformation (juce::MemoryBlock& destData)
     auto paramsTree = PluginHelpers::saveParamsTree (*this);
     auto pluginPreset = juce::ValueTree (getName());
     pluginPreset.appendChild (paramsTree, nullptr);
+
+#if TINTIN_WITH_SAMPLER
+    auto library = getSampleLibrary();
+
+    juce::ValueTree samples ("Samples");
+    samples.setProperty ("folder",  library.folder.getFullPathName(), nullptr);
+    samples.setProperty ("preload", library.preloadFrames, nullptr);
+    pluginPreset.appendChild (samples, nullptr);
+#endif
+
     copyXmlToBinary (*pluginPreset.createXml(), destData);
 }
 
@@ -233,6 +525,22 @@ void TinTinProcessor::setStateInformation (const void* data, int sizeInBytes)
         auto preset     = juce::ValueTree::fromXml (*xml);
         auto paramsTree = preset.getChildWithName ("Params");
         PluginHelpers::loadParamsTree (*this, paramsTree);
+
+#if TINTIN_WITH_SAMPLER
+        auto samples = preset.getChildWithName ("Samples");
+        auto folder  = samples["folder"].toString();
+        auto preload = (int) samples.getProperty ("preload", TintinSampleLoader::defaultPreloadFrames);
+
+        juce::File library;
+
+        if (juce::File::isAbsolutePath (folder))
+            library = juce::File (folder);
+
+        auto current = getSampleLibrary();
+
+        if (library != current.folder || preload != current.preloadFrames)
+            setSampleLibrary (library, preload);
+#endif
     }
 }
 
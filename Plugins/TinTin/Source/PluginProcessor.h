@@ -6,9 +6,16 @@
 
 // #include "Tintin/TintinMapper.h"
 
-#include <juce_audio_formats/juce_audio_formats.h>
-#include "BinaryData.h"
 #include "TintinMapper.h"
+#include "TintinNoteHistory.h"
+#include "TintinPreviewNotes.h"
+#include "TintinSessionCapture.h"
+
+#if TINTIN_WITH_SAMPLER
+    #include <juce_audio_formats/juce_audio_formats.h>
+    #include "TintinSynth.h"
+    #include "TintinSampleLoader.h"
+#endif
 
 struct PianoHighlightState
 {
@@ -29,31 +36,150 @@ public:
     juce::AudioProcessorEditor* createEditor() override;
 
     const PianoHighlightState& getPianoHighlightState() const noexcept { return pianoHighlightState; }
-    juce::MidiKeyboardState&   getPreviewKeyboardState() noexcept      { return previewKeyboardState; }
+    TintinPreviewNotes&        getPreviewNotes() noexcept              { return previewNotes; }
+    TintinNoteHistory&         getNoteHistory() noexcept               { return noteHistory; }
+
+    // the latest a displaced T note can start after the input stops, plus its release
+    double getTailLengthSeconds() const override;
 
     void getStateInformation (juce::MemoryBlock&) override;
     void setStateInformation (const void*, int) override;
 
+    // false in the MIDI effect build, which only outputs MIDI
+    static constexpr bool hasSampler = TINTIN_WITH_SAMPLER;
+
+#if TINTIN_WITH_SAMPLER
+    // output buses: M passthrough voices and T voices. With the T bus disabled
+    // (the default, for hosts that only take the main output) both play on the M bus
+    static constexpr int mBus = 0;
+    static constexpr int tBus = 1;
+
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+
+    // false until the background sample load has handed its sounds to the synth,
+    // until then the plugin only outputs MIDI
+    bool isSampleSetReady() const noexcept { return tPiano.hasSoundSet(); }
+
+    // true while a set asked for (e.g. the conversion prepareToPlay starts for a new
+    // rate) is still loading. The set before it keeps playing meanwhile
+    bool isLoadingSamples() const { return sampleLoader.isLoading(); }
+
+    // plays the samples in folder instead of the embedded piano, streaming each one
+    // from disk after its first preloadFrames, or a sample bank file (see
+    // TintinSampleBank). An empty folder goes back to the embedded piano. Saved
+    // with the plugin state. If it can't be loaded, the set before it keeps playing
+    // (the embedded piano if there was none) and is what the state saves
+    void setSampleLibrary (const juce::File& folder,
+                           int preloadFrames = TintinSampleLoader::defaultPreloadFrames);
+    TintinSampleLoader::Library getSampleLibrary() const;
+
+    // why the last library asked for couldn't be loaded, empty if it could (or still loads)
+    juce::String getSampleLoadError() const;
+
+    // blocks in which a streaming voice had no data from disk
+    uint32_t getNumStreamUnderruns() const noexcept
+    {
+        return mPiano.getNumStreamUnderruns() + tPiano.getNumStreamUnderruns();
+    }
+#else
+    bool isSampleSetReady() const noexcept { return false; }
+    bool isLoadingSamples() const { return false; }
+    juce::String getSampleLoadError() const { return {}; }
+    uint32_t getNumStreamUnderruns() const noexcept { return 0; }
+#endif
+
+    // the locks processBlock takes knowing nothing else holds them while the host
+    // processes (the synths' render locks), for the real-time safety test
+    juce::Array<const juce::CriticalSection*> getAudioThreadLocks() const;
+
+    // displaced T notes scheduled for a later block
+    bool hasPendingTNotes() const noexcept { return ! tintin.scheduler.isEmpty(); }
+
     Parameters& getParams() { return params; }
     const Parameters& getParams() const { return params; }
 
+    // records what the host feeds this instance (blocks, MIDI, playhead, parameter
+    // moves) to file for tintin-replay, see TintinSessionCapture. Set the
+    // TINTIN_CAPTURE_FOLDER environment variable to capture every instance from
+    // its construction on
+    bool startSessionCapture (const juce::File& file) { return sessionRecorder.start (file, *this); }
+    void stopSessionCapture()                          { sessionRecorder.stop(); }
+
 private:
     void updateOptions();
     void updateStaticTGrid();
     void updateHighlightState (const juce::MidiBuffer& mInput,
                                const juce::MidiBuffer& tOutput);
+    void pushNoteHistory (const juce::MidiBuffer& mInput,
+                          const juce::MidiBuffer& tEvents,
+                          int numSamples);
 
-    void loadSample(const void* data, int dataSize, int rootMidiNote);
-    void loadPianoSound();
+#if TINTIN_WITH_SAMPLER
+    void onSoundsLoaded (TintinSoundSet::Ptr sounds, const TintinSampleLoader::Library& library);
+    bool freeRetiredSounds();
+    void acknowledgeSoundSet() noexcept;
+    void renderVoices (juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& mInput);
+#endif
 
     Parameters params;
     TintinMapper tintin;
 
-    juce::Synthesiser      piano;
-    juce::AudioFormatManager formatManager;
+    // set when any parameter moves, so idle blocks only re-read the options then
+    struct OptionsWatcher : juce::AudioProcessorParameter::Listener
+    {
+        std::atomic<bool> changed { true };
+
+        void parameterValueChanged (int, float) override { changed = true; }
+        void parameterGestureChanged (int, bool) override {}
+    };
+
+    OptionsWatcher optionsWatcher;
+
+    // read by getTailLengthSeconds() on the message thread
+    std::atomic<double> displacementSeconds { 0.0 };
+
+#if TINTIN_WITH_SAMPLER
+    std::atomic<double> releaseSeconds      { 0.0 };
+    bool                samplerOn = true;
+    bool                mVoiceWasOn = true; // to release the M notes once when it's switched off
+
+    // one voice group per output bus, both playing the same sound set
+    TintinSynth            mPiano;
+    TintinSynth            tPiano;
+    juce::MidiBuffer       tMidi;         // T notes plus the input's controllers, for tPiano
+    TintinSoundSet::Ptr    pianoSounds;   // written by the loader thread
+
+    // sets replaced by a newer one, each with the generation that replaced it. The
+    // loader thread frees them once the audio thread has started a block on that
+    // generation or a later one, so no noteOn can still be walking their sounds, and
+    // no voice holds one of their sounds any more, so none is deleted by a voice
+    std::vector<std::pair<TintinSoundSet::Ptr, uint32_t>> retiredSounds;
+    std::atomic<uint32_t> soundGeneration { 0 }; // bumped for every set installed
+    std::atomic<uint32_t> audioGeneration { 0 }; // the one the audio thread last saw
+
+    // the library the state saves and new loads start from. Set by the message thread,
+    // put back to the one playing by the loader thread when a load fails
+    juce::CriticalSection       libraryLock;
+    TintinSampleLoader::Library sampleLibrary;
+    TintinSampleLoader::Library playingLibrary; // what pianoSounds was loaded from
+    juce::String                sampleLoadError;
+#endif
 
     PianoHighlightState pianoHighlightState;
-    juce::MidiKeyboardState previewKeyboardState;
+    TintinPreviewNotes previewNotes;
+    juce::MidiBuffer   inputCopy; // the block's input before the mapper transforms it
+
+    TintinNoteHistory noteHistory;
+    juce::int64       historyPosition = 0;
+
+    TintinSessionRecorder sessionRecorder;
+
+#if TINTIN_WITH_SAMPLER
+    // declared last so it is destroyed (and waits for a running load) first
+    TintinSampleLoader sampleLoader { [this] (TintinSoundSet::Ptr sounds, const TintinSampleLoader::Library& library)
+                                      { onSoundsLoaded (sounds, library); },
+                                      [this] { return freeRetiredSounds(); } };
+#endif
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TinTinProcessor)
 };
@@ -0,0 +1,55 @@
+// Plugins/TinTin/Source/TintinKeyZones.cpp
+#include "TintinKeyZones.h"
+#include <algorithm>
+
+float TintinKeyZone::gainForNote(int note) const
+{
+    if (note < lowNote - crossfade || note > highNote + crossfade)
+        return 0.0f;
+
+    auto bandWidth = (float) (2 * crossfade);
+
+    // lower split, shared with the zone below
+    if (lowNote > 0 && note < lowNote + crossfade)
+        return ((float) (note - (lowNote - crossfade)) + 0.5f) / bandWidth;
+
+    // upper split, shared with the zone above
+    if (highNote < 127 && note > highNote - crossfade)
+        return 1.0f - ((float) (note - (highNote + 1 - crossfade)) + 0.5f) / bandWidth;
+
+    return 1.0f;
+}
+
+std::vector<TintinKeyZone> TintinKeyZones::build(std::vector<int> roots,
+                                                 int crossfadeSemitones)
+{
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+
+    std::vector<TintinKeyZone> zones;
+    zones.reserve(roots.size());
+
+    for (size_t i = 0; i < roots.size(); ++i)
+    {
+        TintinKeyZone zone;
+        zone.rootNote = roots[i];
+
+        // ties go to the upper root, so the split is the first key nearer to it
+        zone.lowNote = i == 0 ? 0 : (roots[i - 1] + roots[i] + 1) / 2;
+        zone.highNote = i + 1 == roots.size() ? 127 : (roots[i] + roots[i + 1] + 1) / 2 - 1;
+
+        zones.push_back(zone);
+    }
+
+    // one band width for every split so neighbouring gains keep adding up to 1, and
+    // no band may reach past a neighbouring root or it would swallow whole zones
+    auto crossfade = std::max(crossfadeSemitones, 0);
+
+    for (const auto& zone: zones)
+        crossfade = std::min(crossfade, (zone.highNote - zone.lowNote + 1) / 2);
+
+    for (auto& zone: zones)
+        zone.crossfade = crossfade;
+
+    return zones;
+}
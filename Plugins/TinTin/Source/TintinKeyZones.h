@@ -0,0 +1,26 @@
+// Plugins/TinTin/Source/TintinKeyZones.h
+#pragma once
+
+#include <vector>
+
+// the key range one root sample is responsible for
+struct TintinKeyZone
+{
+    int rootNote = 60;
+    int lowNote = 0;     // first key owned by this zone
+    int highNote = 127;  // last key owned by this zone
+    int crossfade = 0;   // semitones blended with the neighbour on each side of a split
+
+    // 1 inside the zone, linear fade across a crossfade band, 0 elsewhere.
+    // neighbouring zones' gains always add up to 1.
+    float gainForNote(int note) const;
+    bool appliesTo(int note) const { return gainForNote(note) > 0.0f; }
+};
+
+struct TintinKeyZones
+{
+    // splits 0..127 half way between the (unsorted) roots so every key plays the
+    // nearest root sample. crossfadeSemitones > 0 overlaps neighbours around each
+    // split point; only keys inside a band start two voices.
+    static std::vector<TintinKeyZone> build(std::vector<int> roots, int crossfadeSemitones);
+};
@@ -75,6 +75,18 @@ void TintinMapper::resetOrbit()
 {
     settings.orbitCounter = 0;
     scheduler.clear();
+
+    for (auto& channel : heldNotes)
+        for (auto& note : channel)
+            note = {};
+}
+
+void TintinMapper::prepare(int maxEvents, int maxPending)
+{
+    // a note on/off takes 16 bytes in a MidiBuffer
+    out.ensureSize((size_t) maxEvents * 16);
+    tEvents.ensureSize((size_t) maxEvents * 16);
+    scheduler.reserve((size_t) maxPending);
 }
 
 void TintinMapper::process (juce::MidiBuffer& midi,
@@ -84,7 +96,8 @@ void TintinMapper::process (juce::MidiBuffer& midi,
     // build chord for this block
     chord.setFromTriad (settings.rootNote, settings.triad);
 
-    juce::MidiBuffer out;
+    out.clear();
+    tEvents.clear();
 
     // M-voice passthrough
     if (settings.mVoiceOn)
@@ -93,12 +106,9 @@ void TintinMapper::process (juce::MidiBuffer& midi,
             out.addEvent (m.getMessage(), m.samplePosition);
     }
 
-    // skip T-voice if mode == None
-    if (settings.mode == TintinSettings::TMode::None)
-    {
-        midi.swapWith (out);
-        return;
-    }
+    // with the T voice off (mode None) nothing new is mapped, but the keys it still
+    // has sounding get their note-offs and what is already scheduled comes out
+    const bool tVoiceOn = settings.mode != TintinSettings::TMode::None;
 
     // process M→T mapping
     for (const auto m : midi)
@@ -110,12 +120,29 @@ void TintinMapper::process (juce::MidiBuffer& midi,
             continue;
 
         const int mNote = msg.getNoteNumber();
-        const int qNote = applyQuantizer (mNote);
-        const int tNote = computeTintinNote (qNote);
+        auto& held = heldNotes[(msg.getChannel() - 1) & 15][mNote];
+
+        if (! tVoiceOn && (msg.isNoteOn() || ! held.isHeld))
+            continue;
+
+        // a note-off ends the T note its note-on started, at the same delay, even if
+        // the settings, the tempo or the orbit moved on while the key was down
+        if (msg.isNoteOn() || ! held.isHeld)
+        {
+            const double delaySec = getDelaySeconds (settings);
+
+            held.tNote = computeTintinNote (applyQuantizer (mNote));
+            held.delaySamples = juce::jmax (0, (int) std::round (delaySec * sampleRate));
+        }
 
-        const double delaySec = getDelaySeconds (settings);
-        int delaySamples = (int) std::round (delaySec * sampleRate);
-        if (delaySamples < 0) delaySamples = 0;
+        held.isHeld = msg.isNoteOn();
+
+        const int tNote = held.tNote;
+        const int delaySamples = held.delaySamples;
+
+        // above or below the keyboard
+        if (! juce::isPositiveAndBelow (tNote, 128))
+            continue;
 
         if (msg.isNoteOn())
         {
@@ -166,7 +193,8 @@ void TintinMapper::process (juce::MidiBuffer& midi,
     }
 
     // emit all scheduled events for this block
-    scheduler.processBlock (out, numSamples);
+    scheduler.processBlock (tEvents, numSamples);
+    out.addEvents (tEvents, 0, -1, 0);
 
     // swap buffers
     midi.swapWith (out);
@@ -273,6 +301,12 @@ double TintinMapper::getSyncBeats(int index)
     return beats[index];
 }
 
+double TintinMapper::getLatestEventSeconds(const TintinSettings& s)
+{
+    // repeats follow the first T note at the same spacing, see process()
+    return getDelaySeconds(s) * (1 + juce::jmax(0, s.feedbackRepeats));
+}
+
 double TintinMapper::getDelaySeconds(const TintinSettings& s)
 {
     using DM = TintinSettings::DisplacementMode;
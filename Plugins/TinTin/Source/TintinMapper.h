@@ -1,6 +1,6 @@
 #pragma once
 
-#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_audio_basics/juce_audio_basics.h>
 
 #include "TintinSettings.h"
 #include "TintinChord.h"
@@ -12,12 +12,40 @@ struct TintinMapper
     TintinChord     chord;
     TintinScheduler scheduler;
 
+    // T events emitted by the last process() call (delayed/repeated notes included)
+    juce::MidiBuffer tEvents;
+
     void resetOrbit();
+
+    // sizes the buffers and the scheduler queue so process() doesn't allocate for
+    // up to maxEvents MIDI events per block and maxPending scheduled ones. Not on the audio thread
+    void prepare(int maxEvents = 1024, int maxPending = 8192);
+
+    // replaces midi with M passthrough plus T events. midi trades its storage with
+    // a buffer kept here, so both stay allocated from block to block
     void process(juce::MidiBuffer& midi,
                  double sampleRate,
                  int numSamples);
 
+    // how long after an input note its last T event (displaced or repeated) can come out
+    static double getLatestEventSeconds(const TintinSettings& s);
+
+    // the scheduler's events still to come, see TintinScheduler
+    size_t getNumPending() const noexcept { return scheduler.getNumPending(); }
+
 private:
+    juce::MidiBuffer out;
+
+    // the T note and delay each held key's note-on got, per channel, for its note-off
+    struct HeldNote
+    {
+        int  tNote = 0;
+        int  delaySamples = 0;
+        bool isHeld = false;
+    };
+
+    HeldNote heldNotes[16][128];
+
     int computeTintinNote(int mNote);
     int applyVelocity(int mVelocity) const;
     int applyQuantizer(int mNote) const;
@@ -0,0 +1,89 @@
+// Plugins/TinTin/Source/TintinNoteHistory.h
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// one note on/off as seen by the audio thread, kept small so the ring stays cache friendly
+struct TintinNoteEvent
+{
+    enum Voice : uint8_t
+    {
+        M = 0,
+        T = 1
+    };
+
+    juce::int64 timestamp = 0; // absolute sample position since prepareToPlay
+    uint8_t note = 0;
+    uint8_t velocity = 0;      // 0 = note off
+    uint8_t voice = M;
+};
+
+// bounded single-producer / single-consumer ring between audio thread and editor.
+// push() never allocates or blocks; when the UI falls behind, new events are dropped
+// and counted instead.
+class TintinNoteHistory
+{
+public:
+    static constexpr int capacity = 4096;
+
+    // audio thread
+    bool push(const TintinNoteEvent& e) noexcept
+    {
+        auto scope = fifo.write(1);
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        events[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = e;
+        return true;
+    }
+
+    // audio thread, once per block: the time up to which history is complete
+    void advanceTo(juce::int64 timestamp) noexcept
+    {
+        latestTimestamp.store(timestamp, std::memory_order_release);
+    }
+
+    // audio thread, from prepareToPlay: restart the time line
+    void reset() noexcept
+    {
+        latestTimestamp.store(0, std::memory_order_release);
+        epoch.fetch_add(1, std::memory_order_release);
+    }
+
+    // UI thread: copies up to maxEvents into dest, returns how many were read
+    int pop(TintinNoteEvent* dest, int maxEvents) noexcept
+    {
+        auto scope = fifo.read(juce::jmin(maxEvents, fifo.getNumReady()));
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            dest[i] = events[(size_t) (scope.startIndex1 + i)];
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            dest[scope.blockSize1 + i] = events[(size_t) (scope.startIndex2 + i)];
+
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+    juce::int64 getLatestTimestamp() const noexcept
+    {
+        return latestTimestamp.load(std::memory_order_acquire);
+    }
+
+    uint32_t getEpoch() const noexcept { return epoch.load(std::memory_order_acquire); }
+    uint32_t getNumDropped() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    juce::AbstractFifo fifo {capacity};
+    std::array<TintinNoteEvent, capacity> events {};
+
+    std::atomic<juce::int64> latestTimestamp {0};
+    std::atomic<uint32_t> epoch {0};
+    std::atomic<uint32_t> dropped {0};
+};
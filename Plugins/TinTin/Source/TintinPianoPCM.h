@@ -0,0 +1,29 @@
+// Plugins/TinTin/Source/TintinPianoPCM.h
+#pragma once
+
+#include <cstdint>
+
+// the piano samples, converted at build time by Tools/TintinAssetBaker.cpp into
+// 16 bit PCM (leading silence trimmed, normalised together, zero padded) so they
+// can be played straight from this memory without decoding or copying. The voice
+// converts to float as it renders, see TintinVoiceKernels
+namespace TintinPianoPCM
+{
+    // zeros after the last playable sample, so interpolation may read past the end
+    constexpr int padding = 4;
+
+    struct Asset
+    {
+        const char* name;
+        int rootNote;
+        double sampleRate;
+        int numChannels;
+        int numSamples;      // playable length, each channel holds numSamples + padding
+        int loopStart;       // -1 = the file had no loop
+        int loopEnd;
+        const int16_t* const* channels;
+    };
+
+    extern const Asset assets[];
+    extern const int numAssets;
+}
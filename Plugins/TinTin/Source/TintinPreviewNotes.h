@@ -0,0 +1,68 @@
+// Plugins/TinTin/Source/TintinPreviewNotes.h
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+#include <cstdint>
+
+// notes played on the editor's piano, handed from the message thread to the audio
+// thread through a single-producer / single-consumer ring. Unlike
+// juce::MidiKeyboardState nothing here takes a lock. A full ring drops new notes
+class TintinPreviewNotes
+{
+public:
+    static constexpr int capacity = 256;
+
+    // message thread
+    bool push(int channel, int note, float velocity, bool isDown) noexcept
+    {
+        if (! juce::isPositiveAndBelow(note, 128) || channel < 1 || channel > 16)
+            return false;
+
+        auto scope = fifo.write(1);
+
+        if (scope.blockSize1 + scope.blockSize2 == 0)
+            return false;
+
+        notes[(size_t) (scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)] = {
+            (uint8_t) channel,
+            (uint8_t) note,
+            (uint8_t) juce::jlimit(1, 127, juce::roundToInt(velocity * 127.0f)),
+            isDown};
+
+        return true;
+    }
+
+    // audio thread: adds the notes waiting to the start of midi
+    void popInto(juce::MidiBuffer& midi) noexcept
+    {
+        auto scope = fifo.read(fifo.getNumReady());
+
+        auto add = [&](int start, int size)
+        {
+            for (int i = start; i < start + size; ++i)
+            {
+                const auto& n = notes[(size_t) i];
+
+                midi.addEvent(n.isDown ? juce::MidiMessage::noteOn(n.channel, n.note, n.velocity)
+                                       : juce::MidiMessage::noteOff(n.channel, n.note),
+                              0);
+            }
+        };
+
+        add(scope.startIndex1, scope.blockSize1);
+        add(scope.startIndex2, scope.blockSize2);
+    }
+
+private:
+    struct Note
+    {
+        uint8_t channel = 1;
+        uint8_t note = 0;
+        uint8_t velocity = 0;
+        bool isDown = false;
+    };
+
+    juce::AbstractFifo fifo {capacity};
+    std::array<Note, capacity> notes {};
+};
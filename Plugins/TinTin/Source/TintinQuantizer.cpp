@@ -7,27 +7,34 @@ static int wrapPc(int n)
     return pc < 0 ? pc + 12 : pc;
 }
 
-std::vector<int> TintinQuantizer::getScale(int s)
+std::span<const int> TintinQuantizer::getScale(int s)
 {
-    // 0 = chromatic
-    if (s == 0)
-        return { 0,1,2,3,4,5,6,7,8,9,10,11 };
+    static constexpr int chromatic[]        = { 0,1,2,3,4,5,6,7,8,9,10,11 };
+    static constexpr int major[]            = { 0,2,4,5,7,9,11 };
+    static constexpr int naturalMinor[]     = { 0,2,3,5,7,8,10 };
+    static constexpr int dorian[]           = { 0,2,3,5,7,9,10 };
+    static constexpr int phrygian[]         = { 0,1,3,5,7,8,10 };
+    static constexpr int lydian[]           = { 0,2,4,6,7,9,11 };
+    static constexpr int mixolydian[]       = { 0,2,4,5,7,9,10 };
+    static constexpr int locrian[]          = { 0,1,3,5,6,8,10 };
+    static constexpr int pentatonicMajor[]  = { 0,2,4,7,9 };
+    static constexpr int pentatonicMinor[]  = { 0,3,5,7,10 };
 
     switch (s)
     {
-        case 1: return { 0,2,4,5,7,9,11 };       // Major
-        case 2: return { 0,2,3,5,7,8,10 };       // Natural minor
-        case 3: return { 0,2,3,5,7,9,10 };       // Dorian
-        case 4: return { 0,1,3,5,7,8,10 };       // Phrygian
-        case 5: return { 0,2,4,6,7,9,11 };       // Lydian
-        case 6: return { 0,2,4,5,7,9,10 };       // Mixolydian
-        case 7: return { 0,1,3,5,6,8,10 };       // Locrian
-        case 8: return { 0,2,4,7,9 };            // Pentatonic major
-        case 9: return { 0,3,5,7,10 };           // Pentatonic minor
+        case 1: return major;
+        case 2: return naturalMinor;
+        case 3: return dorian;
+        case 4: return phrygian;
+        case 5: return lydian;
+        case 6: return mixolydian;
+        case 7: return locrian;
+        case 8: return pentatonicMajor;
+        case 9: return pentatonicMinor;
     }
 
-    // fallback to chromatic
-    return { 0,1,2,3,4,5,6,7,8,9,10,11 };
+    // 0 and anything unknown: chromatic
+    return chromatic;
 }
 
 int TintinQuantizer::quantize(int midiNote,
@@ -1,7 +1,7 @@
 // Plugins/TinTin/Source/Tintin/TintinQuantizer.h
 #pragma once
 
-#include <vector>
+#include <span>
 
 struct TintinQuantizer
 {
@@ -12,5 +12,6 @@ struct TintinQuantizer
     static int quantize(int midiNote, int scaleIndex, int rootMidiNote);
 
 private:
-    static std::vector<int> getScale(int scaleIndex);
+    // pitch classes of the scale, from static tables so quantizing never allocates
+    static std::span<const int> getScale(int scaleIndex);
 };
@@ -0,0 +1,147 @@
+// Plugins/TinTin/Source/TintinResampler.cpp
+#include "TintinResampler.h"
+#include "TintinVoiceKernels.h"
+
+#include <cmath>
+#include <vector>
+
+namespace TintinResampler
+{
+    // table steps per zero crossing, linearly interpolated in between
+    static constexpr int tableResolution = 1024;
+
+    // passband edge relative to the lower Nyquist limit, leaves room for the transition band
+    static constexpr double passband = 0.95;
+
+    static double besselI0(double x)
+    {
+        auto sum = 1.0;
+        auto term = 1.0;
+
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+
+            if (term < sum * 1.0e-12)
+                break;
+        }
+
+        return sum;
+    }
+
+    // Kaiser windowed sinc from 0 to halfWidth zero crossings
+    static std::vector<float> makeTable()
+    {
+        constexpr double beta = 9.0;
+
+        std::vector<float> table((size_t) (halfWidth * tableResolution + 2), 0.0f);
+        auto norm = besselI0(beta);
+
+        for (int i = 0; i <= halfWidth * tableResolution; ++i)
+        {
+            auto x = (double) i / tableResolution;
+            auto r = x / halfWidth;
+            auto sinc = i == 0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x)
+                                           / (juce::MathConstants<double>::pi * x);
+
+            table[(size_t) i] = (float) (sinc * besselI0(beta * std::sqrt(1.0 - r * r)) / norm);
+        }
+
+        return table;
+    }
+
+    // the source frames as float, converting 16 bit samples to a temporary copy
+    static const float* readChannel(const TintinSampleData& source,
+                                    int channel,
+                                    int numFrames,
+                                    std::vector<float>& converted)
+    {
+        if (! source.isCompact())
+            return source.audio.getReadPointer(channel);
+
+        auto* pcm = source.pcm16[(size_t) channel];
+        converted.resize((size_t) numFrames);
+
+        for (int i = 0; i < numFrames; ++i)
+            converted[(size_t) i] = pcm[i] * TintinVoiceKernels::int16Scale;
+
+        return converted.data();
+    }
+
+    TintinSampleData::Ptr resample(const TintinSampleData& source, double targetRate)
+    {
+        jassert(! source.isStreamed());
+
+        if (targetRate <= 0 || source.sampleRate <= 0 || source.length <= 0)
+            return nullptr;
+
+        static const auto table = makeTable();
+
+        auto ratio = targetRate / source.sampleRate;   // output frames per source frame
+        auto cutoff = juce::jmin(1.0, ratio) * passband; // in units of the source Nyquist
+        auto reach = (double) halfWidth / cutoff;        // source frames on each side
+
+        TintinSampleData::Ptr result = new TintinSampleData();
+        result->sampleRate = targetRate;
+        result->length = juce::jmax(1, (int) std::floor((source.length - 1) * ratio) + 1);
+        result->headLength = result->length;
+
+        auto numChannels = source.getNumChannels();
+        auto numOut = result->length + TintinSampleData::padding;
+        auto numIn = source.isCompact() ? source.length + TintinSampleData::padding
+                                        : juce::jmin(source.audio.getNumSamples(),
+                                                     source.length + TintinSampleData::padding);
+
+        result->audio.setSize(numChannels, numOut);
+
+        std::vector<float> converted[2];
+        const float* channels[2] = {};
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels[ch] = readChannel(source, ch, numIn, converted[ch]);
+
+        std::vector<float> weights;
+        weights.reserve((size_t) (2.0 * reach + 2.0));
+
+        for (int n = 0; n < numOut; ++n)
+        {
+            auto t = n / ratio;
+            auto first = juce::jmax(0, (int) std::ceil(t - reach));
+            auto last = juce::jmin(numIn - 1, (int) std::floor(t + reach));
+
+            weights.clear();
+            auto sum = 0.0f;
+
+            for (int k = first; k <= last; ++k)
+            {
+                auto x = std::abs(t - k) * cutoff * tableResolution;
+                auto index = (int) x;
+                auto frac = (float) (x - index);
+
+                auto w = index < halfWidth * tableResolution
+                             ? table[(size_t) index] + frac * (table[(size_t) index + 1] - table[(size_t) index])
+                             : 0.0f;
+
+                weights.push_back(w);
+                sum += w;
+            }
+
+            // unity gain at DC, also near the edges where part of the kernel is missing
+            auto scale = sum > 0.0f ? 1.0f / sum : 0.0f;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* in = channels[ch];
+                auto acc = 0.0f;
+
+                for (size_t i = 0; i < weights.size(); ++i)
+                    acc += in[first + (int) i] * weights[i];
+
+                result->audio.setSample(ch, n, acc * scale);
+            }
+        }
+
+        return result;
+    }
+}
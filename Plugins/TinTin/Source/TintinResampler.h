@@ -0,0 +1,19 @@
+// Plugins/TinTin/Source/TintinResampler.h
+#pragma once
+
+#include "TintinSampleCache.h"
+
+// offline, band-limited sample rate conversion for samples held in memory.
+// Run once per sample and session rate (see TintinSampleLoader), so notes at
+// their root pitch play a straight copy and transposed ones interpolate with a
+// ratio close to 1 instead of converting the rate on every voice sample
+namespace TintinResampler
+{
+    // zero crossings of the windowed sinc on each side of a source frame
+    constexpr int halfWidth = 32;
+
+    // a copy of source at targetRate. Frequencies above the lower of the two
+    // Nyquist limits are filtered out, so downsampling doesn't alias.
+    // source must hold all of its frames in memory (not streamed), the copy is float
+    TintinSampleData::Ptr resample(const TintinSampleData& source, double targetRate);
+}
@@ -0,0 +1,269 @@
+// Plugins/TinTin/Source/TintinSampleBank.cpp
+#include "TintinSampleBank.h"
+
+#include <cstring>
+#include <map>
+
+namespace TintinSampleBank
+{
+    static constexpr char magic[4] = {'T', 'T', 'B', 'K'};
+    static constexpr uint32_t version = 1;
+    static constexpr uint64_t alignment = 32;
+
+    struct Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t numSounds;
+        uint32_t padding; // frames after each channel's last one, TintinSampleData::padding
+    };
+
+    struct SoundEntry
+    {
+        int32_t rootNote;
+        int32_t lowNote;
+        int32_t highNote;
+        int32_t crossfade;
+
+        int32_t lowVelocity;
+        int32_t highVelocity;
+        int32_t roundRobinIndex;
+        int32_t roundRobinCount;
+
+        int32_t numChannels;
+        int32_t length;         // frames stored, each channel holds length + padding
+        int32_t playableLength; // frames the sound plays, at most length
+        int32_t reserved;
+
+        double sampleRate;
+        uint64_t offset; // first channel, from the start of the file. The second one follows it
+
+        float attack; // seconds
+        float release;
+    };
+
+    // the layout is the file format, it must not depend on the compiler
+    static_assert(sizeof(Header) == 16);
+    static_assert(sizeof(SoundEntry) == 72);
+
+    static uint64_t alignUp(uint64_t bytes)
+    {
+        return (bytes + alignment - 1) & ~(alignment - 1);
+    }
+
+    // bytes from one channel to the next
+    static uint64_t channelBytes(int32_t length)
+    {
+        return alignUp((uint64_t) (length + TintinSampleData::padding) * sizeof(int16_t));
+    }
+
+    static bool isValid(const SoundEntry& e, uint32_t numSounds, uint64_t fileSize)
+    {
+        if (e.numChannels < 1 || e.numChannels > 2 || e.length <= 0
+            || e.playableLength <= 0 || e.playableLength > e.length
+            || ! (e.sampleRate > 0.0) || e.offset % alignment != 0)
+            return false;
+
+        if (! juce::isPositiveAndNotGreaterThan(e.rootNote, 127)
+            || ! juce::isPositiveAndNotGreaterThan(e.lowNote, 127)
+            || ! juce::isPositiveAndNotGreaterThan(e.highNote, 127)
+            || e.lowNote > e.highNote || e.crossfade < 0)
+            return false;
+
+        if (e.lowVelocity < 1 || e.highVelocity > 127 || e.lowVelocity > e.highVelocity
+            || e.roundRobinCount < 1 || ! juce::isPositiveAndBelow(e.roundRobinIndex, e.roundRobinCount))
+            return false;
+
+        if (! (e.attack >= 0.0f) || ! (e.release >= 0.0f))
+            return false;
+
+        auto firstData = sizeof(Header) + (uint64_t) numSounds * sizeof(SoundEntry);
+
+        return e.offset >= firstData && e.offset + channelBytes(e.length) * (uint64_t) e.numChannels <= fileSize;
+    }
+
+    TintinSoundSet::Ptr open(const juce::File& file, TintinSampleCache& cache, const juce::String& contentKey)
+    {
+        auto mapping = std::make_shared<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+        auto* data = static_cast<const char*>(mapping->getData());
+        auto size = (uint64_t) mapping->getSize();
+
+        Header header;
+
+        if (data == nullptr || size < sizeof(Header))
+            return nullptr;
+
+        std::memcpy(&header, data, sizeof(Header));
+
+        if (std::memcmp(header.magic, magic, sizeof(magic)) != 0
+            || header.version != version
+            || header.padding != (uint32_t) TintinSampleData::padding
+            || (size - sizeof(Header)) / sizeof(SoundEntry) < header.numSounds)
+            return nullptr;
+
+        // other instances playing the same file share its samples. Without a
+        // content key, a rewritten file has a new modification time and so new keys
+        auto assetPrefix = (contentKey.isNotEmpty() ? contentKey
+                                                    : file.getFullPathName() + "@"
+                                                          + juce::String(file.getLastModificationTime().toMilliseconds()))
+                           + ":";
+
+        TintinSoundSet::Ptr set = new TintinSoundSet();
+
+        for (uint32_t i = 0; i < header.numSounds; ++i)
+        {
+            SoundEntry entry;
+            std::memcpy(&entry, data + sizeof(Header) + i * sizeof(SoundEntry), sizeof(SoundEntry));
+
+            if (! isValid(entry, header.numSounds, size))
+                return nullptr;
+
+            auto sample = cache.get(assetPrefix + juce::String(entry.offset),
+                                    entry.sampleRate,
+                                    [&]
+                                    {
+                                        const int16_t* channels[2] = {};
+
+                                        for (int ch = 0; ch < entry.numChannels; ++ch)
+                                            channels[ch] = reinterpret_cast<const int16_t*>(
+                                                data + entry.offset + (uint64_t) ch * channelBytes(entry.length));
+
+                                        auto mapped = TintinSampleData::referTo(channels,
+                                                                                entry.numChannels,
+                                                                                entry.length,
+                                                                                entry.sampleRate);
+                                        if (mapped != nullptr)
+                                            mapped->mapping = mapping;
+
+                                        return mapped;
+                                    });
+
+            if (sample == nullptr)
+                return nullptr;
+
+            TintinKeyZone zone;
+            zone.rootNote = entry.rootNote;
+            zone.lowNote = entry.lowNote;
+            zone.highNote = entry.highNote;
+            zone.crossfade = entry.crossfade;
+
+            // half a frame over, so the sound's own rounding lands on playableLength
+            auto* sound = new TintinSamplerSound(sample,
+                                                 zone,
+                                                 entry.attack,
+                                                 entry.release,
+                                                 (entry.playableLength + 0.5) / entry.sampleRate);
+
+            sound->setLayer({entry.lowVelocity, entry.highVelocity, entry.roundRobinIndex, entry.roundRobinCount});
+            set->sounds.add(sound);
+        }
+
+        if (set->sounds.isEmpty())
+            return nullptr;
+
+        return set;
+    }
+
+    bool write(const TintinSoundSet& set, const juce::File& file)
+    {
+        auto numSounds = (uint32_t) set.sounds.size();
+
+        std::vector<SoundEntry> entries;
+        std::vector<const TintinSampleData*> blocks; // 16 bit, in file order
+        std::vector<TintinSampleData::Ptr> converted;
+        std::map<const TintinSampleData*, uint64_t> offsets;
+
+        auto position = alignUp(sizeof(Header) + numSounds * sizeof(SoundEntry));
+
+        for (auto* sound: set.sounds)
+        {
+            auto* sample = sound->getSample();
+
+            if (sample == nullptr || sample->isStreamed())
+                return false;
+
+            auto found = offsets.find(sample);
+
+            if (found == offsets.end())
+            {
+                if (sample->isCompact())
+                {
+                    blocks.push_back(sample);
+                }
+                else
+                {
+                    converted.push_back(TintinSampleData::toInt16(*sample));
+                    blocks.push_back(converted.back().get());
+                }
+
+                found = offsets.emplace(sample, position).first;
+                position += channelBytes(sample->length) * (uint64_t) sample->getNumChannels();
+            }
+
+            const auto& zone = sound->getZone();
+            const auto& layer = sound->getLayer();
+            const auto& envelope = sound->getEnvelopeParameters();
+
+            SoundEntry entry {};
+            entry.rootNote = zone.rootNote;
+            entry.lowNote = zone.lowNote;
+            entry.highNote = zone.highNote;
+            entry.crossfade = zone.crossfade;
+            entry.lowVelocity = layer.lowVelocity;
+            entry.highVelocity = layer.highVelocity;
+            entry.roundRobinIndex = layer.roundRobinIndex;
+            entry.roundRobinCount = layer.roundRobinCount;
+            entry.numChannels = sample->getNumChannels();
+            entry.length = sample->length;
+            entry.playableLength = sound->getLength();
+            entry.sampleRate = sample->sampleRate;
+            entry.offset = found->second;
+            entry.attack = envelope.attack;
+            entry.release = envelope.release;
+
+            entries.push_back(entry);
+        }
+
+        Header header {};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.numSounds = numSounds;
+        header.padding = (uint32_t) TintinSampleData::padding;
+
+        if (! file.getParentDirectory().createDirectory())
+            return false;
+
+        // written next to the file and moved over it, so nobody maps half a bank
+        juce::TemporaryFile temp(file);
+
+        {
+            juce::FileOutputStream out(temp.getFile());
+
+            if (! out.openedOk())
+                return false;
+
+            out.write(&header, sizeof(Header));
+            out.write(entries.data(), entries.size() * sizeof(SoundEntry));
+
+            for (auto* block: blocks)
+            {
+                out.writeRepeatedByte(0, (size_t) (alignUp((uint64_t) out.getPosition()) - (uint64_t) out.getPosition()));
+
+                for (int ch = 0; ch < block->getNumChannels(); ++ch)
+                {
+                    auto bytes = (size_t) (block->length + TintinSampleData::padding) * sizeof(int16_t);
+
+                    out.write(block->pcm16[(size_t) ch], bytes);
+                    out.writeRepeatedByte(0, (size_t) channelBytes(block->length) - bytes);
+                }
+            }
+
+            out.flush();
+
+            if (out.getStatus().failed())
+                return false;
+        }
+
+        return temp.overwriteTargetFileWithTemporary();
+    }
+}
@@ -0,0 +1,27 @@
+// Plugins/TinTin/Source/TintinSampleBank.h
+#pragma once
+
+#include "TintinSampleCache.h"
+#include "TintinSampler.h"
+
+// a sound set packed into one file: a header, one entry per sound (key zone,
+// velocity layer, envelope and where its PCM is) and the 16 bit PCM blocks, each
+// aligned to 32 bytes. A bank is opened with a memory map and the voices play
+// straight from the mapped pages, so opening one costs a header parse and the
+// OS reads the audio in as it's played.
+//
+// Everything is stored little endian, as on every platform the plugin runs on
+namespace TintinSampleBank
+{
+    constexpr const char* fileExtension = ".tintinbank";
+
+    // the sounds of a bank, their samples shared through cache with every other
+    // instance playing it. nullptr if the file isn't a bank of this version or is damaged.
+    // The samples are cached under contentKey, which must change whenever the
+    // file's contents do; empty = the file's path and modification time
+    TintinSoundSet::Ptr open(const juce::File& file, TintinSampleCache& cache, const juce::String& contentKey = {});
+
+    // packs set into file, replacing it atomically. Fails if a sample is streamed
+    // (see TintinSampleData::isStreamed) or the file can't be written
+    bool write(const TintinSoundSet& set, const juce::File& file);
+}
@@ -0,0 +1,132 @@
+// Plugins/TinTin/Source/TintinSampleCache.cpp
+#include "TintinSampleCache.h"
+
+TintinSampleData::Ptr TintinSampleData::fromReader(juce::AudioFormatReader& source,
+                                                   double maxSeconds)
+{
+    if (source.sampleRate <= 0 || source.lengthInSamples <= 0)
+        return nullptr;
+
+    Ptr sample = new TintinSampleData();
+    sample->sampleRate = source.sampleRate;
+    sample->length = juce::jmin((int) source.lengthInSamples,
+                                (int) (maxSeconds * source.sampleRate));
+    sample->headLength = sample->length;
+
+    sample->audio.setSize(juce::jmin(2, (int) source.numChannels), sample->length + padding);
+    source.read(&sample->audio, 0, sample->length + padding, 0, true, true);
+
+    return sample;
+}
+
+TintinSampleData::Ptr TintinSampleData::referTo(const int16_t* const* channels,
+                                                int numChannels,
+                                                int numSamples,
+                                                double sampleRate)
+{
+    if (sampleRate <= 0 || numSamples <= 0 || numChannels <= 0)
+        return nullptr;
+
+    Ptr sample = new TintinSampleData();
+    sample->sampleRate = sampleRate;
+    sample->length = numSamples;
+    sample->headLength = numSamples;
+
+    sample->pcm16[0] = channels[0];
+    sample->pcm16[1] = numChannels > 1 ? channels[1] : nullptr;
+
+    return sample;
+}
+
+TintinSampleData::Ptr TintinSampleData::toInt16(const TintinSampleData& source)
+{
+    jassert(! source.isStreamed() && ! source.isCompact());
+
+    auto numChannels = source.getNumChannels();
+    auto numFrames = source.length + padding;
+
+    Ptr sample = new TintinSampleData();
+    sample->sampleRate = source.sampleRate;
+    sample->length = source.length;
+    sample->headLength = source.length;
+    sample->ownedPcm16.calloc((size_t) (numChannels * numFrames));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* dest = sample->ownedPcm16.get() + ch * numFrames;
+        auto* src = source.audio.getReadPointer(ch);
+        auto numToConvert = juce::jmin(numFrames, source.audio.getNumSamples());
+
+        for (int i = 0; i < numToConvert; ++i)
+            dest[i] = (int16_t) juce::jlimit(-32768, 32767, juce::roundToInt(src[i] * 32768.0f));
+
+        sample->pcm16[(size_t) ch] = dest;
+    }
+
+    return sample;
+}
+
+TintinSampleData::Ptr TintinSampleData::preloadFile(juce::AudioFormatManager& formats,
+                                                    const juce::File& file,
+                                                    int preloadFrames,
+                                                    double maxSeconds)
+{
+    std::unique_ptr<juce::AudioFormatReader> source(formats.createReaderFor(file));
+
+    if (source == nullptr || source->sampleRate <= 0 || source->lengthInSamples <= 0)
+        return nullptr;
+
+    Ptr sample = new TintinSampleData();
+    sample->sampleRate = source->sampleRate;
+    sample->length = juce::jmin((int) source->lengthInSamples,
+                                (int) (maxSeconds * source->sampleRate));
+    sample->headLength = juce::jmin(sample->length, juce::jmax(2, preloadFrames));
+    sample->file = file;
+
+    // the padding after the head is real audio, so interpolating across into the
+    // streamed part reads the same frames it would with the whole file in memory
+    sample->audio.setSize(juce::jmin(2, (int) source->numChannels),
+                          sample->headLength + padding);
+    source->read(&sample->audio, 0, sample->headLength + padding, 0, true, true);
+
+    return sample;
+}
+
+TintinSampleData::Ptr TintinSampleCache::get(const juce::String& asset,
+                                             double sampleRate,
+                                             const Factory& create)
+{
+    // building under the lock is what makes a second instance wait for the
+    // first one's result; builds are rare and happen on loader threads only
+    const juce::ScopedLock sl(lock);
+
+    purgeUnused();
+
+    for (auto& entry: entries)
+    {
+        if (entry.asset == asset && juce::approximatelyEqual(entry.sampleRate, sampleRate))
+            return entry.data;
+    }
+
+    auto data = create();
+
+    if (data != nullptr)
+        entries.push_back({asset, sampleRate, data});
+
+    return data;
+}
+
+int TintinSampleCache::getNumEntries() const
+{
+    const juce::ScopedLock sl(lock);
+    return (int) entries.size();
+}
+
+void TintinSampleCache::purgeUnused()
+{
+    // a reference count of 1 means only the cache still holds the sample
+    entries.erase(std::remove_if(entries.begin(),
+                                 entries.end(),
+                                 [](const Entry& e) { return e.data->getReferenceCount() == 1; }),
+                  entries.end());
+}
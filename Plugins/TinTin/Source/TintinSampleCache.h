@@ -0,0 +1,93 @@
+// Plugins/TinTin/Source/TintinSampleCache.h
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// one sample's PCM. Never modified once built, so any number of sounds in any
+// number of plugin instances can play from the same object
+struct TintinSampleData : public juce::ReferenceCountedObject
+{
+    using Ptr = juce::ReferenceCountedObjectPtr<TintinSampleData>;
+
+    // zeros after the last playable sample, so interpolation may read past the end
+    static constexpr int padding = 4;
+
+    juce::AudioBuffer<float> audio; // numChannels x (headLength + padding)
+    double sampleRate = 44100.0;
+    int length = 0;
+
+    // 16 bit frames used instead of audio when set, at half the memory. Read back
+    // as sample * TintinVoiceKernels::int16Scale by the voice as it renders
+    std::array<const int16_t*, 2> pcm16 {};
+    juce::HeapBlock<int16_t> ownedPcm16;
+    std::shared_ptr<juce::MemoryMappedFile> mapping; // the bank file pcm16 points into, see TintinSampleBank
+
+    bool isCompact() const noexcept { return pcm16[0] != nullptr; }
+
+    int getNumChannels() const noexcept
+    {
+        return isCompact() ? (pcm16[1] != nullptr ? 2 : 1) : audio.getNumChannels();
+    }
+
+    // frames held in audio. A streamed sample only preloads its head, the voice
+    // reads the rest of file through a TintinSampleStream
+    int headLength = 0;
+    juce::File file;
+
+    bool isStreamed() const noexcept { return headLength < length; }
+
+    // decodes up to maxSeconds of the reader into memory owned by the sample
+    static Ptr fromReader(juce::AudioFormatReader& source, double maxSeconds);
+
+    // keeps the first preloadFrames of the file in memory and streams the rest,
+    // files no longer than that are loaded whole
+    static Ptr preloadFile(juce::AudioFormatManager& formats,
+                           const juce::File& file,
+                           int preloadFrames,
+                           double maxSeconds);
+
+    // refers to 16 bit memory owned elsewhere (e.g. baked into the binary) without
+    // copying. each channel must be readable for numSamples + padding and outlive the sample
+    static Ptr referTo(const int16_t* const* channels,
+                       int numChannels,
+                       int numSamples,
+                       double sampleRate);
+
+    // a 16 bit copy of a sample held wholly in memory
+    static Ptr toInt16(const TintinSampleData& source);
+};
+
+// process-wide cache of sample data keyed by asset name and sample rate, shared by
+// every TinTin instance through a juce::SharedResourcePointer. Entries nobody else
+// holds any more are dropped, so memory tracks what the open instances really use.
+class TintinSampleCache
+{
+public:
+    using Factory = std::function<TintinSampleData::Ptr()>;
+
+    // returns the cached sample, or builds it with create() and caches it. Callers
+    // asking while a build runs wait for it instead of building their own copy.
+    // sampleRate is the rate the data is stored at, 0 for whatever the source has
+    TintinSampleData::Ptr get(const juce::String& asset, double sampleRate, const Factory& create);
+
+    int getNumEntries() const;
+
+private:
+    struct Entry
+    {
+        juce::String asset;
+        double sampleRate = 0.0;
+        TintinSampleData::Ptr data;
+    };
+
+    void purgeUnused();
+
+    juce::CriticalSection lock;
+    std::vector<Entry> entries;
+};
@@ -0,0 +1,454 @@
+// Plugins/TinTin/Source/TintinSampleLoader.cpp
+#include "TintinSampleLoader.h"
+#include "TintinPianoPCM.h"
+#include "TintinResampler.h"
+#include "TintinSampleBank.h"
+
+#include <algorithm>
+#include <map>
+
+// the copy of sample voices play from: 16 bit, at playbackRate, built the first time
+// any instance asks. Streamed samples are returned as they are
+static TintinSampleData::Ptr forPlayback(TintinSampleCache& cache,
+                                         const juce::String& asset,
+                                         TintinSampleData::Ptr sample,
+                                         double playbackRate)
+{
+    if (sample == nullptr || sample->isStreamed())
+        return sample;
+
+    auto rate = playbackRate > 0 ? playbackRate : sample->sampleRate;
+    auto atRate = juce::approximatelyEqual(sample->sampleRate, rate);
+
+    if (sample->isCompact() && atRate)
+        return sample;
+
+    auto converted = cache.get(asset + " (16 bit)",
+                               rate,
+                               [&]() -> TintinSampleData::Ptr
+                               {
+                                   auto source = atRate ? sample : TintinResampler::resample(*sample, rate);
+                                   return source != nullptr ? TintinSampleData::toInt16(*source) : nullptr;
+                               });
+
+    return converted != nullptr ? converted : sample;
+}
+
+// the warm cache's bank for the set key describes, none if there is no cache
+static juce::File getWarmBank(const juce::File& warmCache, const juce::String& key)
+{
+    if (warmCache == juce::File())
+        return {};
+
+    return warmCache.getChildFile(juce::String::toHexString(key.hashCode64()) + TintinSampleBank::fileExtension);
+}
+
+// opens a warm bank, marking it as just used for trimWarmCache(). The time is set
+// before the bank is mapped, some systems refuse it for a mapped file. That makes
+// the modification time useless as a cache key, but the name is a hash of what the
+// bank was converted from, so instances share its samples under that
+static TintinSoundSet::Ptr openWarmBank(const juce::File& bank, TintinSampleCache& cache)
+{
+    if (! bank.existsAsFile())
+        return nullptr;
+
+    bank.setLastModificationTime(juce::Time::getCurrentTime());
+    return TintinSampleBank::open(bank, cache, "warm:" + bank.getFileNameWithoutExtension());
+}
+
+static void writeWarmBank(const TintinSoundSet& set, const juce::File& bank)
+{
+    if (TintinSampleBank::write(set, bank))
+        TintinSampleLoader::trimWarmCache(bank.getParentDirectory());
+}
+
+TintinSampleLoader::TintinSampleLoader(Callback onLoadedToUse, Collector collectToUse)
+    : juce::ThreadPoolJob("TinTin piano samples")
+    , onLoaded(std::move(onLoadedToUse))
+    , collect(std::move(collectToUse))
+{
+}
+
+TintinSampleLoader::~TintinSampleLoader()
+{
+    signalJobShouldExit();
+    wakeUp.signal();
+    pool->threads.removeJob(this, true, -1);
+}
+
+void TintinSampleLoader::start(const Library& library)
+{
+    {
+        const juce::ScopedLock sl(requestLock);
+
+        request = library;
+        hasRequest = true;
+        loading = true;
+
+        if (running)
+        {
+            wakeUp.signal(); // the running job picks it up next
+            return;
+        }
+
+        running = true;
+    }
+
+    // a job that has just finished may not have left the pool yet
+    pool->threads.waitForJobToFinish(this, -1);
+    pool->threads.addJob(this, false);
+}
+
+bool TintinSampleLoader::isLoading() const
+{
+    const juce::ScopedLock sl(requestLock);
+    return loading;
+}
+
+juce::ThreadPoolJob::JobStatus TintinSampleLoader::runJob()
+{
+    for (;;)
+    {
+        Library library;
+        bool load = false;
+
+        {
+            const juce::ScopedLock sl(requestLock);
+
+            // running is cleared in the same lock that finds nothing left to do, so a
+            // start() either hands this loop its request or adds the job again
+            if (shouldExit() || (! hasRequest && ! collecting))
+            {
+                running = false;
+                loading = false;
+                return jobHasFinished;
+            }
+
+            if (hasRequest)
+            {
+                library = request;
+                hasRequest = false;
+                load = true;
+            }
+            else
+            {
+                loading = false;
+            }
+        }
+
+        if (load)
+        {
+            TintinSoundSet::Ptr set;
+
+            if (library.folder == juce::File())
+                set = loadPianoSounds(*cache, library.playbackRate, library.warmCache);
+            else if (library.folder.hasFileExtension(TintinSampleBank::fileExtension))
+                set = TintinSampleBank::open(library.folder, *cache);
+            else
+                set = loadSampleFolder(*cache,
+                                       library.folder,
+                                       library.preloadFrames,
+                                       library.playbackRate,
+                                       library.warmCache);
+
+            if (onLoaded)
+                onLoaded(set, library);
+        }
+        else
+        {
+            // only the collector still waiting on the audio thread, or a new start()
+            wakeUp.wait(collectIntervalMs);
+        }
+
+        collecting = collect && collect();
+    }
+}
+
+TintinSoundSet::Ptr TintinSampleLoader::loadPianoSounds(TintinSampleCache& cache,
+                                                        double playbackRate,
+                                                        const juce::File& warmCache)
+{
+    std::vector<int> roots;
+
+    // names the assets of this build, so a rebuilt piano doesn't open an old bank
+    juce::String key("TinTin piano " + juce::String(playbackRate));
+    auto converted = false;
+
+    for (int i = 0; i < TintinPianoPCM::numAssets; ++i)
+    {
+        const auto& asset = TintinPianoPCM::assets[i];
+        roots.push_back(asset.rootNote);
+
+        key << " " << asset.name << ":" << asset.numSamples << ":" << asset.sampleRate << ":";
+
+        for (int frame = 0; frame < asset.numSamples; frame += 4096)
+            key << asset.channels[0][frame] << ",";
+
+        converted = converted || (playbackRate > 0 && ! juce::approximatelyEqual(asset.sampleRate, playbackRate));
+    }
+
+    // at their own rate the baked samples already play straight from the binary
+    auto warmBank = converted ? getWarmBank(warmCache, key) : juce::File();
+
+    if (auto set = openWarmBank(warmBank, cache))
+        return set;
+
+    // each key plays the nearest root: A2 up to C#3, F#3 from D3 to G#3, C4 from A3 up
+    auto zones = TintinKeyZones::build(roots, keyZoneCrossfade);
+
+    TintinSoundSet::Ptr set = new TintinSoundSet();
+
+    for (int i = 0; i < TintinPianoPCM::numAssets; ++i)
+    {
+        const auto& asset = TintinPianoPCM::assets[i];
+
+        auto sample = cache.get(asset.name,
+                                asset.sampleRate,
+                                [&asset]
+                                {
+                                    return TintinSampleData::referTo(asset.channels,
+                                                                     asset.numChannels,
+                                                                     asset.numSamples,
+                                                                     asset.sampleRate);
+                                });
+
+        sample = forPlayback(cache, asset.name, sample, playbackRate);
+
+        if (sample == nullptr)
+            continue;
+
+        for (const auto& zone: zones)
+        {
+            if (zone.rootNote != asset.rootNote)
+                continue;
+
+            set->sounds.add(new TintinSamplerSound(sample,
+                                                   zone,
+                                                   0.0,    // attack
+                                                   0.2,    // release
+                                                   10.0)); // max length
+        }
+    }
+
+    if (set->sounds.isEmpty())
+        return nullptr;
+
+    if (warmBank != juce::File())
+        writeWarmBank(*set, warmBank);
+
+    return set;
+}
+
+TintinSoundSet::Ptr TintinSampleLoader::loadSampleFolder(TintinSampleCache& cache,
+                                                         const juce::File& folder,
+                                                         int preloadFrames,
+                                                         double playbackRate,
+                                                         const juce::File& warmCache)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    // root note -> top velocity of the layer -> round-robin take
+    std::map<int, std::map<int, std::map<int, juce::File>>> files;
+
+    for (const auto& entry: juce::RangedDirectoryIterator(folder,
+                                                          false,
+                                                          formats.getWildcardForAllFormats()))
+    {
+        auto name = parseSampleName(entry.getFile().getFileNameWithoutExtension());
+
+        // the first file found wins if two have the same name apart from case or format
+        if (name.rootNote >= 0)
+            files[name.rootNote][name.topVelocity].emplace(name.roundRobin, entry.getFile());
+    }
+
+    std::vector<int> roots;
+
+    // any file added, removed or changed makes a new key
+    juce::String key(folder.getFullPathName() + " " + juce::String(preloadFrames) + " " + juce::String(playbackRate));
+
+    for (const auto& [note, layers]: files)
+    {
+        roots.push_back(note);
+
+        for (const auto& [velocity, takes]: layers)
+            for (const auto& [index, file]: takes)
+                key << " " << file.getFileName() << ":" << file.getSize() << ":"
+                    << file.getLastModificationTime().toMilliseconds();
+    }
+
+    auto warmBank = getWarmBank(warmCache, key);
+
+    if (auto set = openWarmBank(warmBank, cache))
+        return set;
+
+    auto zones = TintinKeyZones::build(roots, keyZoneCrossfade);
+
+    TintinSoundSet::Ptr set = new TintinSoundSet();
+
+    for (const auto& zone: zones)
+    {
+        const auto& layers = files[zone.rootNote];
+        TintinSampleLayer layer;
+
+        // each layer starts one above the top of the softer one, the loudest goes up to 127
+        for (auto velocity = layers.begin(); velocity != layers.end(); ++velocity)
+        {
+            const auto& takes = velocity->second;
+
+            layer.highVelocity = std::next(velocity) == layers.end() ? 127 : velocity->first;
+            layer.roundRobinIndex = 0;
+            layer.roundRobinCount = (int) takes.size();
+
+            for (const auto& [index, file]: takes)
+            {
+                auto asset = file.getFullPathName() + ":" + juce::String(preloadFrames);
+
+                // 0 = stored at the file's own rate
+                auto sample = cache.get(asset,
+                                        0.0,
+                                        [&]
+                                        {
+                                            return TintinSampleData::preloadFile(formats,
+                                                                                 file,
+                                                                                 preloadFrames,
+                                                                                 maxStreamedSeconds);
+                                        });
+
+                sample = forPlayback(cache, asset, sample, playbackRate);
+
+                if (sample != nullptr)
+                {
+                    auto* sound = new TintinSamplerSound(sample, zone, 0.0, 0.2, maxStreamedSeconds);
+                    sound->setLayer(layer);
+                    set->sounds.add(sound);
+                }
+
+                // a take that can't be read leaves a silent turn rather than shifting the others
+                ++layer.roundRobinIndex;
+            }
+
+            layer.lowVelocity = layer.highVelocity + 1;
+        }
+    }
+
+    if (set->sounds.isEmpty())
+        return nullptr;
+
+    // a bank only holds whole samples, streamed sets are read from their files each time
+    if (warmBank != juce::File() && ! set->isStreamed())
+        writeWarmBank(*set, warmBank);
+
+    return set;
+}
+
+TintinSampleLoader::SampleName TintinSampleLoader::parseSampleName(const juce::String& fileName)
+{
+    auto words = juce::StringArray::fromTokens(fileName, " _", {});
+    words.removeEmptyStrings();
+
+    SampleName name;
+
+    // the layer and take words may come in either order after the note
+    while (! words.isEmpty())
+    {
+        auto word = words[words.size() - 1].toLowerCase();
+
+        if (word.startsWith("rr") && word.length() > 2 && word.substring(2).containsOnly("0123456789"))
+            name.roundRobin = juce::jmax(0, word.substring(2).getIntValue() - 1);
+        else if (word.startsWith("v") && word.length() > 1 && word.substring(1).containsOnly("0123456789"))
+            name.topVelocity = juce::jlimit(1, 127, word.substring(1).getIntValue());
+        else
+            break;
+
+        words.remove(words.size() - 1);
+    }
+
+    name.rootNote = parseRootNote(words.joinIntoString(" "));
+    return name;
+}
+
+juce::File TintinSampleLoader::getDefaultWarmCacheFolder()
+{
+#if JUCE_MAC
+    return juce::File::getSpecialLocation(juce::File::userHomeDirectory).getChildFile("Library/Caches/TinTin");
+#elif JUCE_WINDOWS
+    return juce::File::getSpecialLocation(juce::File::windowsLocalAppData).getChildFile("TinTin/Cache");
+#else
+    auto xdgCache = juce::SystemStats::getEnvironmentVariable("XDG_CACHE_HOME", {});
+
+    auto base = juce::File::isAbsolutePath(xdgCache)
+                    ? juce::File(xdgCache)
+                    : juce::File::getSpecialLocation(juce::File::userHomeDirectory).getChildFile(".cache");
+
+    return base.getChildFile("TinTin");
+#endif
+}
+
+void TintinSampleLoader::trimWarmCache(const juce::File& warmCache, int maxBanks, juce::int64 maxBytes)
+{
+    auto banks = warmCache.findChildFiles(juce::File::findFiles,
+                                          false,
+                                          juce::String("*") + TintinSampleBank::fileExtension);
+
+    // newest first
+    std::sort(banks.begin(), banks.end(), [](const juce::File& a, const juce::File& b)
+    {
+        return a.getLastModificationTime() > b.getLastModificationTime();
+    });
+
+    juce::int64 bytes = 0;
+
+    for (int i = 0; i < banks.size(); ++i)
+    {
+        auto size = banks[i].getSize();
+        bytes += size;
+
+        if (i > 0 && (i >= maxBanks || bytes > maxBytes) && banks[i].deleteFile())
+            bytes -= size;
+    }
+}
+
+int TintinSampleLoader::parseRootNote(const juce::String& fileName)
+{
+    auto words = juce::StringArray::fromTokens(fileName, " _", {});
+    words.removeEmptyStrings();
+
+    if (words.isEmpty())
+        return -1;
+
+    auto word = words[words.size() - 1];
+
+    if (word.containsOnly("0123456789"))
+    {
+        auto note = word.getIntValue();
+        return note <= 127 ? note : -1;
+    }
+
+    static constexpr int semitones[] = {9, 11, 0, 2, 4, 5, 7}; // A..G
+    auto letter = juce::CharacterFunctions::toUpperCase(word[0]);
+
+    if (letter < 'A' || letter > 'G')
+        return -1;
+
+    auto note = semitones[letter - 'A'];
+    auto octave = word.substring(1);
+
+    if (octave.startsWithChar('#') || octave.startsWithChar('s'))
+    {
+        ++note;
+        octave = octave.substring(1);
+    }
+    else if (octave.startsWithChar('b') && octave.length() > 1)
+    {
+        --note;
+        octave = octave.substring(1);
+    }
+
+    if (octave.isEmpty() || ! octave.substring(octave.startsWithChar('-') ? 1 : 0).containsOnly("0123456789"))
+        return -1;
+
+    note += (octave.getIntValue() + 1) * 12;
+
+    return juce::isPositiveAndNotGreaterThan(note, 127) ? note : -1;
+}
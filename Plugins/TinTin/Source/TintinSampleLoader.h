@@ -0,0 +1,132 @@
+// Plugins/TinTin/Source/TintinSampleLoader.h
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <functional>
+
+#include "TintinSampleCache.h"
+#include "TintinSampler.h"
+
+// builds the piano's sound set on a background thread shared by all plugin
+// instances, so constructing a processor never waits for it. The sample data
+// itself comes from the process-wide TintinSampleCache, so every instance plays
+// the same copy.
+//
+// The set is the embedded piano, a folder of samples on disk (which only keep a
+// preloaded head in memory and stream the rest while playing) or a sample bank
+// file (see TintinSampleBank). Sets converted for a session rate are kept as
+// banks in a warm cache folder, so the next session maps them instead of decoding
+class TintinSampleLoader : private juce::ThreadPoolJob
+{
+public:
+    // called on the loader thread after every load, then every collectIntervalMs while
+    // it returns true and nothing else is asked for: frees what the audio thread has
+    // let go of since, so that never happens on the audio thread
+    using Collector = std::function<bool()>;
+    static constexpr int collectIntervalMs = 50;
+
+    // frames of each streamed sample kept in memory, about 0.7 s at 48 kHz
+    static constexpr int defaultPreloadFrames = 32768;
+
+    struct Library
+    {
+        juce::File folder;  // a sample folder or bank file, none = the embedded piano
+        int preloadFrames = defaultPreloadFrames;
+
+        // session rate the samples are converted to, 0 = leave them as recorded.
+        // Streamed samples and banks always play as they were stored
+        double playbackRate = 0.0;
+
+        // where converted sets are kept between sessions, none = convert every time
+        juce::File warmCache;
+    };
+
+    // called on the loader thread with the finished set (nullptr if nothing could be
+    // read) and the library it was loaded from
+    using Callback = std::function<void(TintinSoundSet::Ptr, const Library&)>;
+
+    explicit TintinSampleLoader(Callback onLoaded, Collector collect = {});
+    ~TintinSampleLoader() override; // waits for a load that is already running
+
+    // loads library in the background. Called again while a load runs, the newest
+    // library is loaded right after it
+    void start(const Library& library = {});
+
+    // true from start() until the last library asked for has been handed to the callback
+    bool isLoading() const;
+
+    // the synchronous loads the job runs. The embedded piano wraps the baked PCM from
+    // TintinPianoPCM.h; a folder uses every audio file named after its root note,
+    // velocity layer and round-robin take (see parseSampleName). Files longer than
+    // preloadFrames are streamed after that, shorter ones are held as 16 bit PCM
+    static TintinSoundSet::Ptr loadPianoSounds(TintinSampleCache& cache,
+                                               double playbackRate = 0.0,
+                                               const juce::File& warmCache = {});
+    static TintinSoundSet::Ptr loadSampleFolder(TintinSampleCache& cache,
+                                                const juce::File& folder,
+                                                int preloadFrames,
+                                                double playbackRate = 0.0,
+                                                const juce::File& warmCache = {});
+
+    // the user's cache folder for this plugin, e.g. ~/Library/Caches/TinTin on macOS
+    static juce::File getDefaultWarmCacheFolder();
+
+    // every new rate, folder content or preload size adds a bank to the warm cache.
+    // After each one is written the least recently used are deleted until at most
+    // maxWarmBanks and maxWarmCacheBytes are left, the newest bank always staying
+    static constexpr int maxWarmBanks = 8;
+    static constexpr juce::int64 maxWarmCacheBytes = (juce::int64) 2 << 30;
+
+    // deletes least recently used banks (by modification time, which opening one
+    // renews) beyond the limits. Banks another instance has open may stay
+    static void trimWarmCache(const juce::File& warmCache,
+                              int maxBanks = maxWarmBanks,
+                              juce::int64 maxBytes = maxWarmCacheBytes);
+
+    // the MIDI note a sample file is named after: the last word of the name, either
+    // a note number ("60") or a note name with C4 = 60 ("C4", "F#3", "Fs3", "Bb2").
+    // -1 if it isn't one
+    static int parseRootNote(const juce::String& fileName);
+
+    struct SampleName
+    {
+        int rootNote = -1;
+        int topVelocity = 127; // highest MIDI velocity of the file's layer
+        int roundRobin = 0;    // take within the layer, from 0
+    };
+
+    // the root note followed by optional "vNN" and "rrN" words, e.g. "Piano C4 v80 rr2"
+    // is the second take of the layer played up to velocity 80. Without them a file
+    // is the only take of the only layer
+    static SampleName parseSampleName(const juce::String& fileName);
+
+    // streamed samples aren't held in memory, so they may be much longer
+    static constexpr double maxStreamedSeconds = 60.0;
+
+    // semitones blended between neighbouring root samples around each split point.
+    // 0 = hard splits, every note starts exactly one voice
+    static constexpr int keyZoneCrossfade = 0;
+
+private:
+    struct Pool
+    {
+        juce::ThreadPool threads {juce::ThreadPoolOptions {}
+                                      .withThreadName("TinTin sample loader")
+                                      .withNumberOfThreads(2)};
+    };
+
+    JobStatus runJob() override;
+
+    juce::SharedResourcePointer<Pool> pool;
+    juce::SharedResourcePointer<TintinSampleCache> cache;
+    Callback onLoaded;
+    Collector collect;
+    juce::WaitableEvent wakeUp;
+
+    juce::CriticalSection requestLock;
+    Library request;
+    bool hasRequest = false;
+    bool loading = false; // a request is waiting or being loaded
+    bool running = false; // the job is in the pool, loading or collecting
+    bool collecting = false; // the job thread's own
+};
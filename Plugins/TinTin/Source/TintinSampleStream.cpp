@@ -0,0 +1,185 @@
+// Plugins/TinTin/Source/TintinSampleStream.cpp
+#include "TintinSampleStream.h"
+
+void TintinSampleStream::allocate(int capacityFrames, std::atomic<uint32_t>* underrunCounter)
+{
+    jassert(state.load() == idle);
+
+    capacity = juce::jmax(chunkSize, capacityFrames);
+    ring.setSize(2, capacity + TintinSampleData::padding);
+    ring.clear();
+    scratch.setSize(2, chunkSize);
+    underruns = underrunCounter;
+}
+
+bool TintinSampleStream::tryStart(TintinSampleData* sampleToStream) noexcept
+{
+    if (capacity == 0 || state.load(std::memory_order_acquire) != idle)
+        return false;
+
+    // the disk thread doesn't touch an idle stream, so none of this races
+    sample = sampleToStream;
+    startFrame = sampleToStream->headLength;
+    framesWritten.store(startFrame, std::memory_order_relaxed);
+    framesConsumed.store(startFrame, std::memory_order_relaxed);
+
+    state.store(requested, std::memory_order_release);
+    return true;
+}
+
+void TintinSampleStream::stop() noexcept
+{
+    state.store(stopping, std::memory_order_release);
+}
+
+int TintinSampleStream::getWindow(juce::int64 firstFrame,
+                                  const float*& left,
+                                  const float*& right) const noexcept
+{
+    auto available = framesWritten.load(std::memory_order_acquire) - firstFrame;
+
+    if (available <= 0 || firstFrame < startFrame)
+        return 0;
+
+    auto slot = (int) (firstFrame % capacity);
+
+    left = ring.getReadPointer(0, slot);
+    right = ring.getReadPointer(1, slot);
+
+    return (int) juce::jmin(available, (juce::int64) (capacity + TintinSampleData::padding - slot));
+}
+
+void TintinSampleStream::setConsumed(juce::int64 frame) noexcept
+{
+    framesConsumed.store(juce::jmax(frame, startFrame), std::memory_order_release);
+}
+
+void TintinSampleStream::countUnderrun() noexcept
+{
+    if (underruns != nullptr)
+        underruns->fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TintinSampleStream::service(juce::AudioFormatManager& formats)
+{
+    auto current = state.load(std::memory_order_acquire);
+
+    if (current == idle)
+        return false;
+
+    if (current == stopping)
+    {
+        sample = nullptr;
+        state.store(idle, std::memory_order_release);
+        return false;
+    }
+
+    if (current == requested)
+    {
+        // a file that can't be opened leaves the voice starved, it counts the underruns
+        openReader(formats);
+
+        auto expected = (int) requested;
+
+        if (! state.compare_exchange_strong(expected, streaming, std::memory_order_acq_rel))
+            return true; // stopped in the meantime, picked up on the next pass
+    }
+
+    if (reader == nullptr)
+        return false;
+
+    auto written = framesWritten.load(std::memory_order_relaxed);
+    auto end = (juce::int64) sample->length + TintinSampleData::padding;
+    auto limit = framesConsumed.load(std::memory_order_acquire) + capacity;
+    auto numFrames = (int) juce::jmin((juce::int64) chunkSize, end - written, limit - written);
+
+    if (numFrames <= 0)
+        return false;
+
+    reader->read(&scratch, 0, numFrames, written, true, true);
+    write(written, numFrames);
+
+    framesWritten.store(written + numFrames, std::memory_order_release);
+
+    return written + numFrames < juce::jmin(end, limit);
+}
+
+void TintinSampleStream::openReader(juce::AudioFormatManager& formats)
+{
+    if (reader != nullptr && readerFile == sample->file)
+        return;
+
+    reader.reset(formats.createReaderFor(sample->file));
+    readerFile = reader != nullptr ? sample->file : juce::File();
+}
+
+void TintinSampleStream::write(juce::int64 frame, int numFrames) noexcept
+{
+    constexpr auto padding = TintinSampleData::padding;
+
+    for (int done = 0; done < numFrames;)
+    {
+        auto slot = (int) (frame % capacity);
+        auto n = juce::jmin(numFrames - done, capacity - slot);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            ring.copyFrom(ch, slot, scratch, ch, done, n);
+
+            if (slot < padding)
+                ring.copyFrom(ch, capacity + slot, scratch, ch, done, juce::jmin(n, padding - slot));
+        }
+
+        frame += n;
+        done += n;
+    }
+}
+
+TintinStreamPool::TintinStreamPool()
+{
+    formats.registerBasicFormats();
+}
+
+void TintinStreamPool::allocate(int count, int capacityFrames)
+{
+    if (isAllocated() || count <= 0)
+        return;
+
+    streams = std::make_unique<TintinSampleStream[]>((size_t) count);
+
+    for (int i = 0; i < count; ++i)
+        streams[(size_t) i].allocate(capacityFrames, &underruns);
+
+    numStreams.store(count, std::memory_order_release);
+}
+
+TintinSampleStream* TintinStreamPool::acquire(TintinSampleData* sample) noexcept
+{
+    auto count = numStreams.load(std::memory_order_acquire);
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (streams[(size_t) i].tryStart(sample))
+            return &streams[(size_t) i];
+    }
+
+    underruns.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+bool TintinStreamPool::service()
+{
+    auto count = numStreams.load(std::memory_order_acquire);
+    auto more = false;
+
+    for (int i = 0; i < count; ++i)
+        more = streams[(size_t) i].service(formats) || more;
+
+    return more;
+}
+
+int TintinStreamPool::useTimeSlice()
+{
+    // straight back if a stream is still behind, otherwise check again in 2 ms
+    return service() ? 0 : 2;
+}
@@ -0,0 +1,117 @@
+// Plugins/TinTin/Source/TintinSampleStream.h
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <memory>
+
+#include "TintinSampleCache.h"
+
+// plays the part of a streamed sample that isn't preloaded: a ring of frames the
+// disk thread keeps filling ahead of the voice reading it.
+//
+// Ownership moves between the threads with the state: the audio thread may only
+// start an idle stream, the disk thread takes it from there, and only the disk
+// thread puts a stopped stream back to idle (dropping the sample off the audio thread)
+class TintinSampleStream
+{
+public:
+    // frames read from disk per visit of the disk thread
+    static constexpr int chunkSize = 2048;
+
+    // not on the audio thread
+    void allocate(int capacityFrames, std::atomic<uint32_t>* underrunCounter);
+
+    // audio thread: starts reading sample from the end of its preloaded head.
+    // false if the stream is still busy with a previous note
+    bool tryStart(TintinSampleData* sample) noexcept;
+    void stop() noexcept;
+
+    // audio thread: points left/right at the ring from firstFrame on and returns how
+    // many contiguous frames are ready there, 0 if none are
+    int getWindow(juce::int64 firstFrame, const float*& left, const float*& right) const noexcept;
+
+    // audio thread: frames before this one may be overwritten
+    void setConsumed(juce::int64 frame) noexcept;
+
+    void countUnderrun() noexcept;
+
+    // disk thread: reads the next chunk, returns true if there is more to read right away
+    bool service(juce::AudioFormatManager& formats);
+
+private:
+    enum State
+    {
+        idle,
+        requested,
+        streaming,
+        stopping
+    };
+
+    void openReader(juce::AudioFormatManager& formats);
+    void write(juce::int64 frame, int numFrames) noexcept;
+
+    std::atomic<int> state {idle};
+
+    // set by the audio thread while idle, used and released by the disk thread
+    TintinSampleData::Ptr sample;
+    juce::int64 startFrame = 0;
+
+    std::atomic<juce::int64> framesWritten {0};
+    std::atomic<juce::int64> framesConsumed {0};
+
+    // channel data of frame f sits at f % capacity, the first padding frames are
+    // repeated after the end so a window across the wrap stays contiguous
+    juce::AudioBuffer<float> ring;
+    int capacity = 0;
+
+    // disk thread only
+    juce::AudioBuffer<float> scratch;
+    std::unique_ptr<juce::AudioFormatReader> reader;
+    juce::File readerFile;
+
+    std::atomic<uint32_t>* underruns = nullptr;
+};
+
+// the streams of one synth, serviced by the disk thread all instances share
+class TintinStreamPool : public juce::TimeSliceClient
+{
+public:
+    // frames per stream, about 170 ms at 48 kHz
+    static constexpr int defaultCapacity = 8192;
+
+    TintinStreamPool();
+
+    // allocates the streams the first time it's called, does nothing after that.
+    // never on the audio thread
+    void allocate(int numStreams, int capacityFrames = defaultCapacity);
+    bool isAllocated() const noexcept { return numStreams.load(std::memory_order_acquire) > 0; }
+
+    // audio thread: an idle stream now reading sample, nullptr if all are busy.
+    // A note that finds none stops at the end of its preloaded head and counts as an underrun
+    TintinSampleStream* acquire(TintinSampleData* sample) noexcept;
+
+    // blocks in which a voice had no data to play
+    uint32_t getNumUnderruns() const noexcept { return underruns.load(std::memory_order_relaxed); }
+
+    // disk thread (or a test standing in for it): one pass over all streams,
+    // returns true if any of them still has data to read
+    bool service();
+
+    int useTimeSlice() override;
+
+private:
+    juce::AudioFormatManager formats;
+
+    std::unique_ptr<TintinSampleStream[]> streams;
+    std::atomic<int> numStreams {0};
+    std::atomic<uint32_t> underruns {0};
+};
+
+// the one disk thread of the process
+struct TintinStreamingThread
+{
+    TintinStreamingThread() { thread.startThread(juce::Thread::Priority::high); }
+
+    juce::TimeSliceThread thread {"TinTin disk streaming"};
+};
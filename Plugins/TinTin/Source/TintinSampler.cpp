@@ -0,0 +1,369 @@
+// Plugins/TinTin/Source/TintinSampler.cpp
+#include "TintinSampler.h"
+
+TintinSamplerSound::TintinSamplerSound(TintinSampleData::Ptr sampleToUse,
+                                       const TintinKeyZone& zoneToUse,
+                                       double attackTimeSecs,
+                                       double releaseTimeSecs,
+                                       double maxSampleLengthSeconds)
+    : sample(std::move(sampleToUse))
+    , zone(zoneToUse)
+{
+    if (sample != nullptr)
+    {
+        sourceSampleRate = sample->sampleRate;
+        length = juce::jmin(sample->length, (int) (maxSampleLengthSeconds * sourceSampleRate));
+
+        params.attack = (float) attackTimeSecs;
+        params.release = (float) releaseTimeSecs;
+    }
+}
+
+TintinSamplerSound::TintinSamplerSound(juce::AudioFormatReader& source,
+                                       const TintinKeyZone& zoneToUse,
+                                       double attackTimeSecs,
+                                       double releaseTimeSecs,
+                                       double maxSampleLengthSeconds)
+    : TintinSamplerSound(TintinSampleData::fromReader(source, maxSampleLengthSeconds),
+                         zoneToUse,
+                         attackTimeSecs,
+                         releaseTimeSecs,
+                         maxSampleLengthSeconds)
+{
+}
+
+void TintinVoiceEnvelope::setup(double sampleRate, float attackSecs, float releaseSecs)
+{
+    attackSamples = juce::roundToInt(attackSecs * sampleRate);
+    releaseSamples = juce::roundToInt(releaseSecs * sampleRate);
+}
+
+void TintinVoiceEnvelope::noteOn()
+{
+    if (attackSamples > 0)
+    {
+        stage = Stage::Attack;
+        level = 0.0f;
+        step = 1.0f / (float) attackSamples;
+        samplesLeft = attackSamples;
+        return;
+    }
+
+    stage = Stage::Sustain;
+    level = 1.0f;
+    step = 0.0f;
+}
+
+void TintinVoiceEnvelope::noteOff()
+{
+    if (releaseSamples <= 0 || level <= 0.0f)
+    {
+        reset();
+        return;
+    }
+
+    stage = Stage::Release;
+    step = -level / (float) releaseSamples;
+    samplesLeft = releaseSamples;
+}
+
+void TintinVoiceEnvelope::reset()
+{
+    stage = Stage::Idle;
+    level = 0.0f;
+    step = 0.0f;
+    samplesLeft = 0;
+}
+
+int TintinVoiceEnvelope::getSegmentLength(int maxSamples) const noexcept
+{
+    if (stage == Stage::Attack || stage == Stage::Release)
+        return juce::jmin(samplesLeft, maxSamples);
+
+    return maxSamples;
+}
+
+void TintinVoiceEnvelope::advance(int numSamples) noexcept
+{
+    if (stage != Stage::Attack && stage != Stage::Release)
+        return;
+
+    level += step * (float) numSamples;
+    samplesLeft -= numSamples;
+
+    if (samplesLeft > 0)
+        return;
+
+    if (stage == Stage::Attack)
+    {
+        stage = Stage::Sustain;
+        level = 1.0f;
+        step = 0.0f;
+        return;
+    }
+
+    reset();
+}
+
+bool TintinSamplerVoice::canPlaySound(juce::SynthesiserSound* sound)
+{
+    return dynamic_cast<const TintinSamplerSound*>(sound) != nullptr;
+}
+
+void TintinSamplerVoice::startNote(int midiNoteNumber,
+                                   float velocity,
+                                   juce::SynthesiserSound* s,
+                                   int)
+{
+    auto* sound = dynamic_cast<const TintinSamplerSound*>(s);
+
+    if (sound == nullptr)
+    {
+        jassertfalse; // this object can only play TintinSamplerSounds!
+        return;
+    }
+
+    auto pitchRatio = std::pow(2.0, (midiNoteNumber - sound->zone.rootNote) / 12.0)
+                      * sound->sourceSampleRate / getSampleRate();
+
+    playhead.position = 0;
+    playhead.increment = TintinVoiceKernels::toFixed(pitchRatio);
+    playhead.endPosition = (uint64_t) sound->length << TintinVoiceKernels::fractionBits;
+
+    // inside a crossfade band this voice only carries its share of the note
+    auto gain = velocity * sound->zone.gainForNote(midiNoteNumber);
+    playhead.gainL = gain;
+    playhead.gainR = gain;
+
+    envelope.setup(getSampleRate(), sound->params.attack, sound->params.release);
+    envelope.noteOn();
+
+    releaseStream(playhead);
+
+    if (streamPool != nullptr && sound->sample != nullptr && sound->sample->isStreamed())
+        playhead.stream = streamPool->acquire(sound->sample.get());
+
+    updateActiveFlag();
+}
+
+void TintinSamplerVoice::stopNote(float, bool allowTailOff)
+{
+    if (allowTailOff)
+    {
+        envelope.noteOff();
+        return;
+    }
+
+    // hard stop (stolen voice or all-notes-off): fade the old note out quickly
+    // next to whatever this voice starts next, instead of cutting it
+    if (getCurrentlyPlayingSound() != nullptr && envelope.isActive() && envelope.level > 0.0f)
+    {
+        // the note's stream moves along with it
+        releaseStream(tailPlayhead);
+
+        tailSound = getCurrentlyPlayingSound();
+        tailPlayhead = playhead;
+        tailEnvelope = envelope;
+        tailEnvelope.setup(getSampleRate(), 0.0f, (float) stealFadeSeconds);
+        tailEnvelope.noteOff();
+
+        playhead.stream = nullptr;
+    }
+
+    releaseStream(playhead);
+    clearCurrentNote();
+    envelope.reset();
+
+    updateActiveFlag();
+}
+
+void TintinSamplerVoice::reset() noexcept
+{
+    releaseStream(tailPlayhead);
+    tailSound = nullptr;
+
+    releaseStream(playhead);
+    clearCurrentNote();
+    envelope.reset();
+
+    updateActiveFlag();
+}
+
+void TintinSamplerVoice::updateActiveFlag() noexcept
+{
+    if (activeWord == nullptr)
+        return;
+
+    if (isVoiceActive() || tailSound != nullptr)
+        *activeWord |= activeBit;
+    else
+        *activeWord &= ~activeBit;
+}
+
+void TintinSamplerVoice::releaseStream(Playhead& head) noexcept
+{
+    if (head.stream != nullptr)
+    {
+        head.stream->stop();
+        head.stream = nullptr;
+    }
+}
+
+bool TintinSamplerVoice::getWindow(const TintinSampleData& sample,
+                                   const Playhead& head,
+                                   Window& window) noexcept
+{
+    auto index = (juce::int64) (head.position >> TintinVoiceKernels::fractionBits);
+
+    if (! sample.isStreamed() || index < sample.headLength)
+    {
+        if (sample.isCompact())
+        {
+            window.left16 = sample.pcm16[0];
+            window.right16 = sample.pcm16[1];
+        }
+        else
+        {
+            window.left = sample.audio.getReadPointer(0);
+            window.right = sample.audio.getNumChannels() > 1 ? sample.audio.getReadPointer(1) : nullptr;
+        }
+
+        window.firstFrame = 0;
+        window.numFrames = sample.isStreamed() ? 0 : sample.length + TintinSampleData::padding;
+        window.lastPosition = sample.isStreamed()
+                                  ? ((uint64_t) sample.headLength << TintinVoiceKernels::fractionBits) - 1
+                                  : head.endPosition;
+        return true;
+    }
+
+    const float* left = nullptr;
+    const float* right = nullptr;
+
+    auto numFrames = head.stream != nullptr ? head.stream->getWindow(index, left, right) : 0;
+
+    if (numFrames < 2)
+        return false;
+
+    window.left = left;
+    window.right = sample.audio.getNumChannels() > 1 ? right : nullptr;
+    window.firstFrame = index;
+    window.lastPosition = juce::jmin(
+        ((uint64_t) (index + numFrames - 1) << TintinVoiceKernels::fractionBits) - 1,
+        head.endPosition);
+    return true;
+}
+
+bool TintinSamplerVoice::renderSound(const TintinSamplerSound& sound,
+                                     TintinVoiceKernels::Interpolation interpolation,
+                                     Playhead& head,
+                                     TintinVoiceEnvelope& env,
+                                     juce::AudioBuffer<float>& outputBuffer,
+                                     int startSample,
+                                     int numSamples)
+{
+    if (sound.sample == nullptr)
+        return true;
+
+    TintinVoiceKernels::Block block;
+    block.increment = head.increment;
+    block.gainL = head.gainL;
+    block.gainR = head.gainR;
+    block.interpolation = interpolation;
+
+    while (numSamples > 0 && env.isActive())
+    {
+        Window window;
+
+        if (! getWindow(*sound.sample, head, window))
+        {
+            // without a stream the head was all there is. With one the disk thread
+            // is behind: the note holds its place and the envelope runs on
+            if (head.stream == nullptr)
+                return true;
+
+            head.stream->countUnderrun();
+
+            while (numSamples > 0 && env.isActive())
+            {
+                auto todo = env.getSegmentLength(numSamples);
+                env.advance(todo);
+                numSamples -= todo;
+            }
+
+            return false;
+        }
+
+        auto samplesToEnd = (int) juce::jmin((window.lastPosition - head.position) / head.increment + 1,
+                                             (uint64_t) numSamples);
+
+        auto todo = juce::jmin(samplesToEnd, env.getSegmentLength(numSamples));
+        auto offset = (uint64_t) window.firstFrame << TintinVoiceKernels::fractionBits;
+
+        block.inL = window.left;
+        block.inR = window.right;
+        block.inL16 = window.left16;
+        block.inR16 = window.right16;
+        block.numFrames = window.numFrames;
+        block.outL = outputBuffer.getWritePointer(0, startSample);
+        block.outR = outputBuffer.getNumChannels() > 1
+                         ? outputBuffer.getWritePointer(1, startSample)
+                         : nullptr;
+        block.numSamples = todo;
+        block.position = head.position - offset;
+        block.envelope = env.level;
+        block.envelopeStep = env.step;
+
+        head.position = TintinVoiceKernels::render(block) + offset;
+        env.advance(todo);
+
+        if (head.stream != nullptr)
+            head.stream->setConsumed((juce::int64) (head.position >> TintinVoiceKernels::fractionBits));
+
+        startSample += todo;
+        numSamples -= todo;
+
+        if (head.position > head.endPosition)
+            return true;
+    }
+
+    return false;
+}
+
+void TintinSamplerVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer,
+                                         int startSample,
+                                         int numSamples)
+{
+    renderSeparately(outputBuffer, outputBuffer, startSample, numSamples);
+    updateActiveFlag();
+}
+
+void TintinSamplerVoice::renderSeparately(juce::AudioBuffer<float>& tailBuffer,
+                                          juce::AudioBuffer<float>& noteBuffer,
+                                          int startSample,
+                                          int numSamples)
+{
+    if (tailSound != nullptr)
+    {
+        auto& sound = static_cast<const TintinSamplerSound&>(*tailSound);
+
+        if (renderSound(sound, interpolation, tailPlayhead, tailEnvelope, tailBuffer, startSample, numSamples)
+            || ! tailEnvelope.isActive()
+            || isInaudible(tailPlayhead, tailEnvelope))
+        {
+            releaseStream(tailPlayhead);
+            tailSound = nullptr;
+        }
+    }
+
+    if (auto* sound = static_cast<TintinSamplerSound*>(getCurrentlyPlayingSound().get()))
+    {
+        if (renderSound(*sound, interpolation, playhead, envelope, noteBuffer, startSample, numSamples)
+            || ! envelope.isActive()
+            || isInaudible(playhead, envelope))
+        {
+            releaseStream(playhead);
+            clearCurrentNote();
+            envelope.reset();
+        }
+    }
+}
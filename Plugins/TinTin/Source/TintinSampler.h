@@ -0,0 +1,273 @@
+// Plugins/TinTin/Source/TintinSampler.h
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include "TintinKeyZones.h"
+#include "TintinSampleCache.h"
+#include "TintinSampleStream.h"
+#include "TintinVoiceKernels.h"
+
+// which note-ons a sound in a zone takes: a velocity range, and one of several
+// takes of the same note played in turn (round-robin) so repeats don't sound identical
+struct TintinSampleLayer
+{
+    int lowVelocity = 1;   // MIDI velocities, inclusive
+    int highVelocity = 127;
+    int roundRobinIndex = 0;
+    int roundRobinCount = 1;
+
+    // counter advances once per note-on of the key, see TintinSynth::noteOn
+    bool isPickedFor(int midiVelocity, uint32_t counter) const noexcept
+    {
+        return midiVelocity >= lowVelocity && midiVelocity <= highVelocity
+               && (int) (counter % (uint32_t) roundRobinCount) == roundRobinIndex;
+    }
+};
+
+// a root sample that only answers for the keys of its zone, so a note-on
+// starts one voice instead of one per loaded sample. Several sounds may share
+// a zone as velocity layers or round-robin takes, see TintinSampleLayer
+class TintinSamplerSound : public juce::SynthesiserSound
+{
+public:
+    // plays shared sample data, see TintinSampleCache
+    TintinSamplerSound(TintinSampleData::Ptr sample,
+                       const TintinKeyZone& zone,
+                       double attackTimeSecs,
+                       double releaseTimeSecs,
+                       double maxSampleLengthSeconds);
+
+    // decodes the reader into sample data only this sound uses
+    TintinSamplerSound(juce::AudioFormatReader& source,
+                       const TintinKeyZone& zone,
+                       double attackTimeSecs,
+                       double releaseTimeSecs,
+                       double maxSampleLengthSeconds);
+
+    bool appliesToNote(int midiNoteNumber) override { return zone.appliesTo(midiNoteNumber); }
+    bool appliesToChannel(int) override { return true; }
+
+    const TintinKeyZone& getZone() const noexcept { return zone; }
+
+    void setLayer(const TintinSampleLayer& newLayer) noexcept { layer = newLayer; }
+    const TintinSampleLayer& getLayer() const noexcept { return layer; }
+
+    const TintinSampleData* getSample() const noexcept { return sample.get(); }
+
+    // playable frames, at most the sample's length
+    int getLength() const noexcept { return length; }
+    const juce::ADSR::Parameters& getEnvelopeParameters() const noexcept { return params; }
+
+private:
+    friend class TintinSamplerVoice;
+
+    TintinSampleData::Ptr sample;
+    double sourceSampleRate = 44100.0;
+    int length = 0;
+
+    TintinKeyZone zone;
+    TintinSampleLayer layer;
+    juce::ADSR::Parameters params;
+
+    JUCE_LEAK_DETECTOR(TintinSamplerSound)
+};
+
+// the sounds a TintinSynth plays, built off the audio thread and handed over whole
+struct TintinSoundSet : public juce::ReferenceCountedObject
+{
+    using Ptr = juce::ReferenceCountedObjectPtr<TintinSoundSet>;
+
+    juce::ReferenceCountedArray<TintinSamplerSound> sounds;
+
+    // how long a note rings on after its key is released
+    double getLongestRelease() const
+    {
+        double longest = 0.0;
+
+        for (auto* sound: sounds)
+            longest = juce::jmax(longest, (double) sound->getEnvelopeParameters().release);
+
+        return longest;
+    }
+
+    // a voice holds one of the sounds, as the note it plays or the tail it fades out
+    bool isInUse() const noexcept
+    {
+        for (auto* sound: sounds)
+            if (sound->getReferenceCount() > 1)
+                return true;
+
+        return false;
+    }
+
+    bool isStreamed() const
+    {
+        for (auto* sound: sounds)
+            if (sound->getSample() != nullptr && sound->getSample()->isStreamed())
+                return true;
+
+        return false;
+    }
+};
+
+// linear attack and release, stepped a whole segment at a time so the render
+// kernel can apply it as a ramp instead of evaluating it per sample
+struct TintinVoiceEnvelope
+{
+    enum class Stage
+    {
+        Idle,
+        Attack,
+        Sustain,
+        Release
+    };
+
+    void setup(double sampleRate, float attackSecs, float releaseSecs);
+    void noteOn();
+    void noteOff();
+    void reset();
+
+    bool isActive() const noexcept { return stage != Stage::Idle; }
+
+    // samples left in the current linear segment, at most maxSamples
+    int getSegmentLength(int maxSamples) const noexcept;
+    void advance(int numSamples) noexcept;
+
+    Stage stage = Stage::Idle;
+    float level = 0.0f;
+    float step = 0.0f;
+    int samplesLeft = 0;
+
+    int attackSamples = 0;
+    int releaseSamples = 0;
+};
+
+class TintinSamplerVoice : public juce::SynthesiserVoice
+{
+public:
+    // length of the fade a hard-stopped (stolen) note gets instead of a click
+    static constexpr double stealFadeSeconds = 0.004;
+
+    // a releasing note is ended once its level falls below this (-80 dB)
+    static constexpr float silenceLevel = 1.0e-4f;
+
+    bool canPlaySound(juce::SynthesiserSound*) override;
+
+    void startNote(int midiNoteNumber,
+                   float velocity,
+                   juce::SynthesiserSound*,
+                   int currentPitchWheelPosition) override;
+    void stopNote(float velocity, bool allowTailOff) override;
+
+    void pitchWheelMoved(int) override {}
+    void controllerMoved(int, int) override {}
+
+    void renderNextBlock(juce::AudioBuffer<float>&, int startSample, int numSamples) override;
+    using juce::SynthesiserVoice::renderNextBlock;
+
+    // renderNextBlock() with the stolen-note tail added to tailBuffer and the note to
+    // noteBuffer, for rendering voices on other threads. It leaves the active flag
+    // alone, call updateActiveFlag() on the synth's thread afterwards
+    void renderSeparately(juce::AudioBuffer<float>& tailBuffer,
+                          juce::AudioBuffer<float>& noteBuffer,
+                          int startSample,
+                          int numSamples);
+
+    // lets TintinSynth skip idle voices: the bit stays set while the voice
+    // plays a note or is still fading out a stolen one
+    void setActiveFlag(uint64_t* word, uint64_t bit) noexcept
+    {
+        activeWord = word;
+        activeBit = bit;
+    }
+
+    void updateActiveFlag() noexcept;
+
+    // silent at once: the note and a stolen note's tail both end without a fade,
+    // their streams go back to the pool
+    void reset() noexcept;
+
+    // current output level, for picking a voice to steal
+    float getLoudness() const noexcept
+    {
+        return envelope.level * juce::jmax(playhead.gainL, playhead.gainR);
+    }
+
+    bool isReleasing() const noexcept
+    {
+        return envelope.stage == TintinVoiceEnvelope::Stage::Release;
+    }
+
+    // where notes on streamed samples get their streams from, see TintinSampleData::isStreamed()
+    void setStreamPool(TintinStreamPool* pool) noexcept { streamPool = pool; }
+
+    // applies to samples held in memory, streamed ones always play linear
+    void setInterpolation(TintinVoiceKernels::Interpolation newInterpolation) noexcept
+    {
+        interpolation = newInterpolation;
+    }
+
+private:
+    struct Playhead
+    {
+        uint64_t position = 0;    // 32.32 fixed point, see TintinVoiceKernels
+        uint64_t increment = 0;
+        uint64_t endPosition = 0;
+        float gainL = 0.0f;
+        float gainR = 0.0f;
+
+        TintinSampleStream* stream = nullptr; // reads on after a streamed sample's head
+    };
+
+    // the source frames a playhead can read right now: the preloaded head, or the
+    // part of its stream that has arrived. lastPosition is the furthest position
+    // whose two interpolation frames are both inside. Compact samples (see
+    // TintinSampleData::isCompact) are read through left16/right16 instead
+    struct Window
+    {
+        const float* left = nullptr;
+        const float* right = nullptr;
+        const int16_t* left16 = nullptr;
+        const int16_t* right16 = nullptr;
+        juce::int64 firstFrame = 0;
+        uint64_t lastPosition = 0;
+        int numFrames = 0; // readable from firstFrame on, 0 for streams (linear only)
+    };
+
+    static bool getWindow(const TintinSampleData& sample, const Playhead& head, Window& window) noexcept;
+    static void releaseStream(Playhead& head) noexcept;
+
+    // returns true once the playhead ran past the end of the sample
+    static bool renderSound(const TintinSamplerSound& sound,
+                            TintinVoiceKernels::Interpolation interpolation,
+                            Playhead& head,
+                            TintinVoiceEnvelope& env,
+                            juce::AudioBuffer<float>& outputBuffer,
+                            int startSample,
+                            int numSamples);
+
+    // releasing and already below silenceLevel
+    static bool isInaudible(const Playhead& head, const TintinVoiceEnvelope& env) noexcept
+    {
+        return env.stage == TintinVoiceEnvelope::Stage::Release
+               && env.level * juce::jmax(head.gainL, head.gainR) < silenceLevel;
+    }
+
+    Playhead playhead;
+    TintinVoiceEnvelope envelope;
+
+    // a stolen note keeps sounding here for stealFadeSeconds next to the new one
+    juce::SynthesiserSound::Ptr tailSound;
+    Playhead tailPlayhead;
+    TintinVoiceEnvelope tailEnvelope;
+
+    uint64_t* activeWord = nullptr;
+    uint64_t activeBit = 0;
+
+    TintinStreamPool* streamPool = nullptr;
+    TintinVoiceKernels::Interpolation interpolation = TintinVoiceKernels::Interpolation::linear;
+
+    JUCE_LEAK_DETECTOR(TintinSamplerVoice)
+};
@@ -4,6 +4,8 @@
 void TintinScheduler::clear()
 {
     queue.clear();
+    now = 0;
+    earliestDue = std::numeric_limits<juce::int64>::max();
 }
 
 void TintinScheduler::add(const juce::MidiMessage& msg,
@@ -12,25 +14,41 @@ void TintinScheduler::add(const juce::MidiMessage& msg,
 {
     Pending p;
     p.msg = msg;
-    p.samplesRemaining = baseSamplePos + delaySamples;
+    p.due = now + baseSamplePos + delaySamples;
 
+    earliestDue = juce::jmin(earliestDue, p.due);
     queue.emplace_back(p);
 }
 
 void TintinScheduler::processBlock(juce::MidiBuffer& out,
                                    int numSamples)
 {
-    for (auto it = queue.begin(); it != queue.end();)
+    auto end = now + numSamples;
+
+    if (earliestDue < end)
     {
-        if (it->samplesRemaining < numSamples)
+        // one pass emitting what is due and closing the gaps, keeping the rest in order
+        auto kept = queue.begin();
+        earliestDue = std::numeric_limits<juce::int64>::max();
+
+        for (auto it = queue.begin(); it != queue.end(); ++it)
         {
-            auto pos = juce::jmax(0, it->samplesRemaining);
-            out.addEvent(it->msg, pos);
-            it = queue.erase(it);
-            continue;
+            if (it->due < end)
+            {
+                out.addEvent(it->msg, (int) juce::jmax((juce::int64) 0, it->due - now));
+                continue;
+            }
+
+            earliestDue = juce::jmin(earliestDue, it->due);
+
+            if (kept != it)
+                *kept = std::move(*it);
+
+            ++kept;
         }
 
-        it->samplesRemaining -= numSamples;
-        ++it;
+        queue.erase(kept, queue.end());
     }
+
+    now = end;
 }
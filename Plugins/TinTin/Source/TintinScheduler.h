@@ -1,7 +1,8 @@
 // Plugins/TinTin/Source/Tintin/TintinScheduler.h
 #pragma once
 
-#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <limits>
 #include <vector>
 
 struct TintinScheduler
@@ -9,15 +10,27 @@ struct TintinScheduler
     struct Pending
     {
         juce::MidiMessage msg;
-        int samplesRemaining = 0;  // when this hits < numSamples, event is in current block
+        juce::int64 due = 0;  // in samples since clear(), on the scheduler's own clock
     };
 
     void clear();
+
+    // room for this many pending events before add() allocates
+    void reserve(size_t numEvents) { queue.reserve(numEvents); }
     void add(const juce::MidiMessage& msg,
              int delaySamples,
              int baseSamplePos);
+
+    // moves the events due in the next numSamples to out, in the order they were
+    // added where they fall on the same sample. Blocks with nothing due don't touch the queue
     void processBlock(juce::MidiBuffer& out, int numSamples);
 
+    // nothing waiting to be emitted in a later block
+    bool isEmpty() const noexcept { return queue.empty(); }
+    size_t getNumPending() const noexcept { return queue.size(); }
+
 private:
     std::vector<Pending> queue;
+    juce::int64 now = 0;                                            // start of the current block
+    juce::int64 earliestDue = std::numeric_limits<juce::int64>::max();
 };
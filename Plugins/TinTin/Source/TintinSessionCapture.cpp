@@ -0,0 +1,401 @@
+// Plugins/TinTin/Source/TintinSessionCapture.cpp
+#include "TintinSessionCapture.h"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+// appends values to a fixed buffer, noting when one no longer fits
+class TintinSessionRecorder::Writer
+{
+public:
+    Writer(uint8_t* buffer, size_t capacity) : data(buffer), size(capacity) {}
+
+    template <typename T>
+    void put(T value) noexcept
+    {
+        putBytes(&value, sizeof(T));
+    }
+
+    void putBytes(const void* bytes, size_t numBytes) noexcept
+    {
+        if (used + numBytes > size)
+        {
+            overflow = true;
+            return;
+        }
+
+        std::memcpy(data + used, bytes, numBytes);
+        used += numBytes;
+    }
+
+    // overwrites a value put earlier, at the offset used was then
+    template <typename T>
+    void putAt(size_t offset, T value) noexcept
+    {
+        if (offset + sizeof(T) <= used)
+            std::memcpy(data + offset, &value, sizeof(T));
+    }
+
+    uint8_t* data;
+    size_t size;
+    size_t used = 0;
+    bool overflow = false;
+};
+
+// drains the ring to the file every few milliseconds
+class TintinSessionFlusher : public juce::Thread
+{
+public:
+    explicit TintinSessionFlusher(std::function<void()> drain)
+        : juce::Thread("TinTin session capture"), writeOut(std::move(drain))
+    {
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wait(20);
+            writeOut();
+        }
+    }
+
+private:
+    std::function<void()> writeOut;
+};
+
+TintinSessionRecorder::TintinSessionRecorder() = default;
+
+TintinSessionRecorder::~TintinSessionRecorder()
+{
+    stop();
+}
+
+bool TintinSessionRecorder::start(const juce::File& file, juce::AudioProcessor& processor)
+{
+    stop();
+
+    file.deleteFile();
+    stream = std::make_unique<juce::FileOutputStream>(file);
+
+    if (! stream->openedOk())
+    {
+        stream.reset();
+        return false;
+    }
+
+    // all allocated here, capturing only copies
+    ring.allocate((size_t) ringBytes, false);
+    scratch.allocate((size_t) maxRecordBytes, false);
+    fifo.reset();
+    dropped = 0;
+
+    parameters = processor.getParameters();
+    lastValues.assign((size_t) parameters.size(), std::nanf("")); // the first block has them all
+
+    stream->write(TintinSessionFormat::magic, sizeof(TintinSessionFormat::magic));
+    stream->writeInt((int) TintinSessionFormat::version);
+    stream->writeInt(parameters.size());
+
+    for (auto* p: parameters)
+    {
+        auto id = juce::String(p->getParameterIndex());
+
+        if (auto* withID = dynamic_cast<juce::HostedAudioProcessorParameter*>(p))
+            id = withID->getParameterID();
+
+        stream->writeShort((short) id.getNumBytesAsUTF8());
+        stream->write(id.toRawUTF8(), id.getNumBytesAsUTF8());
+    }
+
+    stream->writeInt(processor.getTotalNumOutputChannels());
+
+    flusher = std::make_unique<TintinSessionFlusher>([this] { writeOut(); });
+    flusher->startThread(juce::Thread::Priority::low);
+
+    recording = true;
+    return true;
+}
+
+void TintinSessionRecorder::stop()
+{
+    if (! recording.exchange(false))
+        return;
+
+    // a capture that saw recording still on finishes before the ring is read for the last time
+    while (capturing.load())
+        juce::Thread::yield();
+
+    flusher->stopThread(1000);
+    flusher.reset();
+    writeOut();
+
+    stream->writeByte((char) TintinSessionFormat::end);
+    stream->writeInt64((juce::int64) dropped.load());
+    stream->flush();
+    stream.reset();
+}
+
+template <typename Fn>
+void TintinSessionRecorder::captureRecord(Fn&& write) noexcept
+{
+    capturing = true;
+
+    if (recording.load())
+    {
+        Writer writer(scratch.get(), (size_t) maxRecordBytes);
+        write(writer);
+
+        auto numBytes = (int) writer.used;
+
+        if (writer.overflow || fifo.getFreeSpace() < numBytes)
+        {
+            dropped.fetch_add(1);
+        }
+        else
+        {
+            auto scope = fifo.write(numBytes);
+            std::memcpy(ring.get() + scope.startIndex1, scratch.get(), (size_t) scope.blockSize1);
+            std::memcpy(ring.get() + scope.startIndex2,
+                        scratch.get() + scope.blockSize1,
+                        (size_t) scope.blockSize2);
+        }
+    }
+
+    capturing = false;
+}
+
+void TintinSessionRecorder::capturePrepare(double sampleRate, int maxBlockSize) noexcept
+{
+    captureRecord([&](Writer& w)
+    {
+        w.put((uint8_t) TintinSessionFormat::prepare);
+        w.put(sampleRate);
+        w.put((int32_t) maxBlockSize);
+    });
+}
+
+void TintinSessionRecorder::capture(int numSamples,
+                                    const juce::MidiBuffer& midi,
+                                    juce::AudioPlayHead* playHead) noexcept
+{
+    if (! recording.load(std::memory_order_relaxed))
+        return;
+
+    captureRecord([&](Writer& w)
+    {
+        w.put((uint8_t) TintinSessionFormat::block);
+        w.put((int32_t) numSamples);
+
+        uint8_t flags = 0;
+        double bpm = 0.0, ppq = 0.0;
+        juce::int64 time = 0;
+
+        if (playHead != nullptr)
+        {
+            if (auto position = playHead->getPosition())
+            {
+                flags |= TintinSessionFormat::hasPlayHead;
+                flags |= position->getIsPlaying() ? TintinSessionFormat::isPlaying : 0;
+
+                if (auto b = position->getBpm())
+                {
+                    flags |= TintinSessionFormat::hasBpm;
+                    bpm = *b;
+                }
+
+                if (auto p = position->getPpqPosition())
+                {
+                    flags |= TintinSessionFormat::hasPpq;
+                    ppq = *p;
+                }
+
+                if (auto t = position->getTimeInSamples())
+                {
+                    flags |= TintinSessionFormat::hasTime;
+                    time = *t;
+                }
+            }
+        }
+
+        w.put(flags);
+        w.put(bpm);
+        w.put(ppq);
+        w.put((int64_t) time);
+
+        // only the values that moved since the last block, each read once as the
+        // message thread may move it again meanwhile. The count goes in afterwards
+        auto countOffset = w.used;
+        uint16_t numChanged = 0;
+        w.put(numChanged);
+
+        for (size_t i = 0; i < lastValues.size(); ++i)
+        {
+            auto value = parameters.getUnchecked((int) i)->getValue();
+
+            if (value != lastValues[i])
+            {
+                w.put((uint16_t) i);
+                w.put(value);
+                lastValues[i] = value;
+                ++numChanged;
+            }
+        }
+
+        w.putAt(countOffset, numChanged);
+
+        w.put((uint32_t) midi.getNumEvents());
+
+        for (const auto m: midi)
+        {
+            w.put((int32_t) m.samplePosition);
+            w.put((uint16_t) m.numBytes);
+            w.putBytes(m.data, (size_t) m.numBytes);
+        }
+    });
+}
+
+void TintinSessionRecorder::writeOut()
+{
+    auto scope = fifo.read(fifo.getNumReady());
+
+    if (scope.blockSize1 > 0)
+        stream->write(ring.get() + scope.startIndex1, (size_t) scope.blockSize1);
+
+    if (scope.blockSize2 > 0)
+        stream->write(ring.get() + scope.startIndex2, (size_t) scope.blockSize2);
+}
+
+template <typename T>
+bool TintinSessionReader::read(T& value)
+{
+    if (position + sizeof(T) > data.getSize())
+        return false;
+
+    std::memcpy(&value, static_cast<const char*>(data.getData()) + position, sizeof(T));
+    position += sizeof(T);
+    return true;
+}
+
+bool TintinSessionReader::open(const juce::File& file, juce::String& error)
+{
+    if (! file.loadFileAsData(data))
+    {
+        error = "can't read " + file.getFullPathName();
+        return false;
+    }
+
+    position = 0;
+    parameterIDs.clear();
+
+    char magic[4] = {};
+    uint32_t version = 0, numParameters = 0;
+
+    for (auto& c: magic)
+        read(c);
+
+    if (std::memcmp(magic, TintinSessionFormat::magic, sizeof(magic)) != 0 || ! read(version)
+        || version != TintinSessionFormat::version || ! read(numParameters))
+    {
+        error = file.getFileName() + " is not a TinTin session capture";
+        return false;
+    }
+
+    for (uint32_t i = 0; i < numParameters; ++i)
+    {
+        uint16_t length = 0;
+
+        if (! read(length) || position + length > data.getSize())
+        {
+            error = file.getFileName() + " is cut short";
+            return false;
+        }
+
+        parameterIDs.add(juce::String::fromUTF8(static_cast<const char*>(data.getData()) + position, length));
+        position += length;
+    }
+
+    int32_t channels = 0;
+
+    if (! read(channels))
+    {
+        error = file.getFileName() + " is cut short";
+        return false;
+    }
+
+    numOutputChannels = channels;
+    firstRecord = position;
+    return true;
+}
+
+bool TintinSessionReader::readNext(Record& record)
+{
+    uint8_t type = 0;
+
+    if (! read(type))
+        return false;
+
+    record.type = (TintinSessionFormat::RecordType) type;
+
+    if (type == TintinSessionFormat::end)
+        return read(record.droppedBlocks);
+
+    if (type == TintinSessionFormat::prepare)
+    {
+        int32_t maxBlockSize = 0;
+
+        if (! read(record.sampleRate) || ! read(maxBlockSize))
+            return false;
+
+        record.maxBlockSize = maxBlockSize;
+        return true;
+    }
+
+    if (type != TintinSessionFormat::block)
+        return false;
+
+    int32_t numSamples = 0;
+    int64_t time = 0;
+    uint16_t numChanged = 0;
+
+    if (! read(numSamples) || ! read(record.playHeadFlags) || ! read(record.bpm) || ! read(record.ppq)
+        || ! read(time) || ! read(numChanged))
+        return false;
+
+    record.numSamples = numSamples;
+    record.timeInSamples = time;
+    record.parameterChanges.clear();
+
+    for (uint16_t i = 0; i < numChanged; ++i)
+    {
+        uint16_t index = 0;
+        float value = 0.0f;
+
+        if (! read(index) || ! read(value))
+            return false;
+
+        record.parameterChanges.emplace_back((int) index, value);
+    }
+
+    uint32_t numEvents = 0;
+
+    if (! read(numEvents))
+        return false;
+
+    record.midi.clear();
+
+    for (uint32_t i = 0; i < numEvents; ++i)
+    {
+        int32_t samplePosition = 0;
+        uint16_t size = 0;
+
+        if (! read(samplePosition) || ! read(size) || position + size > data.getSize())
+            return false;
+
+        record.midi.addEvent(static_cast<const char*>(data.getData()) + position, size, samplePosition);
+        position += size;
+    }
+
+    return true;
+}
@@ -0,0 +1,142 @@
+// Plugins/TinTin/Source/TintinSessionCapture.h
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// A session capture is what a host fed one plugin instance, block by block: the
+// sample count, MIDI, playhead and every parameter value that changed, plus each
+// prepareToPlay. tintin-replay plays it back through a processor, so real host
+// sessions can be profiled and compared run against run.
+//
+// File layout (little-endian, like every platform TinTin builds for):
+//   header:  "TTSN", uint32 version, uint32 parameter count, each parameter ID as
+//            uint16 length + UTF-8, uint32 output channel count
+//   records: uint8 type, then
+//     prepare: double sample rate, int32 maximum block size
+//     block:   int32 samples, uint8 playhead flags, double bpm, double ppq,
+//              int64 time in samples, uint16 changed parameters, each as uint16
+//              index + float value, uint32 MIDI events, each as int32 position +
+//              uint16 size + bytes
+//     end:     uint64 blocks dropped because the ring was full
+struct TintinSessionFormat
+{
+    static constexpr char magic[4] = {'T', 'T', 'S', 'N'};
+    static constexpr uint32_t version = 1;
+
+    enum RecordType : uint8_t
+    {
+        end = 0,
+        prepare = 1,
+        block = 2
+    };
+
+    enum PlayHeadFlags : uint8_t
+    {
+        hasPlayHead = 1,
+        isPlaying = 2,
+        hasBpm = 4,
+        hasPpq = 8,
+        hasTime = 16
+    };
+};
+
+// the capturing side, owned by the processor. capture() and capturePrepare() only
+// copy into a preallocated ring and never block. A background thread writes the
+// ring to the file. If it falls behind, whole blocks are dropped and counted, and
+// the count is stored at the end of the file
+class TintinSessionRecorder
+{
+public:
+    static constexpr int ringBytes = 8 << 20;
+    static constexpr int maxRecordBytes = 64 << 10; // a block with more MIDI is dropped
+
+    TintinSessionRecorder();
+    ~TintinSessionRecorder();
+
+    // writes the header for processor's parameters and starts capturing to file.
+    // Message thread, not while the processor processes
+    bool start(const juce::File& file, juce::AudioProcessor& processor);
+
+    // stops capturing and writes out what is left. Message thread
+    void stop();
+
+    bool isRecording() const noexcept { return recording.load(); }
+
+    // audio thread (or wherever prepareToPlay runs, never at the same time)
+    void capturePrepare(double sampleRate, int maxBlockSize) noexcept;
+    void capture(int numSamples, const juce::MidiBuffer& midi, juce::AudioPlayHead* playHead) noexcept;
+
+private:
+    class Writer;
+
+    template <typename Fn>
+    void captureRecord(Fn&& write) noexcept;
+    void writeOut();
+
+    juce::AbstractFifo fifo {ringBytes};
+    juce::HeapBlock<uint8_t> ring;
+    juce::HeapBlock<uint8_t> scratch;
+
+    juce::Array<juce::AudioProcessorParameter*> parameters;
+    std::vector<float> lastValues;
+
+    std::atomic<bool> recording {false};
+    std::atomic<bool> capturing {false};
+    std::atomic<uint64_t> dropped {0};
+
+    std::unique_ptr<juce::FileOutputStream> stream;
+    std::unique_ptr<juce::Thread> flusher;
+};
+
+// the replaying side: a capture file read back record by record
+class TintinSessionReader
+{
+public:
+    struct Record
+    {
+        TintinSessionFormat::RecordType type = TintinSessionFormat::end;
+
+        // prepare
+        double sampleRate = 0.0;
+        int maxBlockSize = 0;
+
+        // block
+        int numSamples = 0;
+        uint8_t playHeadFlags = 0;
+        double bpm = 0.0;
+        double ppq = 0.0;
+        juce::int64 timeInSamples = 0;
+        std::vector<std::pair<int, float>> parameterChanges; // index into getParameterIDs()
+        juce::MidiBuffer midi;
+
+        // end
+        uint64_t droppedBlocks = 0;
+    };
+
+    // false (with the reason in error) if file isn't a readable session capture
+    bool open(const juce::File& file, juce::String& error);
+
+    const juce::StringArray& getParameterIDs() const noexcept { return parameterIDs; }
+    int getNumOutputChannels() const noexcept { return numOutputChannels; }
+
+    // the next record, false at the end of the file or where it is cut short
+    bool readNext(Record& record);
+
+    // back to the first record
+    void rewind() noexcept { position = firstRecord; }
+
+private:
+    template <typename T>
+    bool read(T& value);
+
+    juce::MemoryBlock data;
+    size_t position = 0;
+    size_t firstRecord = 0;
+
+    juce::StringArray parameterIDs;
+    int numOutputChannels = 0;
+};
@@ -0,0 +1,364 @@
+// Plugins/TinTin/Source/TintinSynth.cpp
+#include "TintinSynth.h"
+
+TintinSynth::TintinSynth()
+{
+    for (int i = 0; i < maxVoices; ++i)
+    {
+        auto* voice = new TintinSamplerVoice();
+        voice->setActiveFlag(&activeMask[(size_t) i / 64], 1ull << (i % 64));
+        voice->setStreamPool(&streams);
+        addVoice(voice);
+    }
+}
+
+TintinSynth::~TintinSynth()
+{
+    // waits for a pass over our streams that is already running
+    if (streamingThread != nullptr)
+        (*streamingThread)->thread.removeTimeSliceClient(&streams);
+}
+
+void TintinSynth::prepareStreaming()
+{
+    if (streamingThread != nullptr)
+        return;
+
+    streams.allocate(maxVoices * 2);
+
+    // the thread is only created once an instance actually streams
+    streamingThread = std::make_unique<juce::SharedResourcePointer<TintinStreamingThread>>();
+    (*streamingThread)->thread.addTimeSliceClient(&streams);
+}
+
+void TintinSynth::prepareParallel(int maxBlockSize, int numVoices)
+{
+    numVoices = juce::jlimit(1, maxVoices, numVoices);
+
+    if (maxBlockSize > scratchSize || numVoices > scratchVoices)
+    {
+        scratchSize = juce::jmax(scratchSize, maxBlockSize);
+        scratchVoices = juce::jmax(scratchVoices, numVoices);
+        scratch.allocate((size_t) scratchVoices * 4 * (size_t) scratchSize, false);
+    }
+
+    if (workerPool == nullptr)
+        workerPool = std::make_unique<juce::SharedResourcePointer<TintinWorkerPool>>();
+}
+
+void TintinSynth::setVoiceLimit(int numVoices) noexcept
+{
+    voiceLimit = juce::jlimit(1, maxVoices, numVoices);
+}
+
+void TintinSynth::setInterpolation(TintinVoiceKernels::Interpolation newInterpolation) noexcept
+{
+    if (newInterpolation == interpolation)
+        return;
+
+    interpolation = newInterpolation;
+
+    for (auto* voice: voices)
+        static_cast<TintinSamplerVoice*>(voice)->setInterpolation(interpolation);
+}
+
+int TintinSynth::getNumActiveVoices() const noexcept
+{
+    int count = 0;
+
+    for (auto word: activeMask)
+        count += std::popcount(word);
+
+    return count;
+}
+
+uint64_t TintinSynth::limitBits(size_t word) const noexcept
+{
+    auto first = (int) word * 64;
+
+    if (voiceLimit >= first + 64)
+        return ~0ull;
+
+    if (voiceLimit <= first)
+        return 0;
+
+    return (1ull << (voiceLimit - first)) - 1;
+}
+
+void TintinSynth::noteOn(int midiChannel, int midiNoteNumber, float velocity)
+{
+    const juce::ScopedLock sl(lock);
+
+    auto midiVelocity = juce::jlimit(1, 127, juce::roundToInt(velocity * 127.0f));
+    auto counter = juce::isPositiveAndBelow(midiNoteNumber, 128) ? noteOnCounts[(size_t) midiNoteNumber]++ : 0u;
+
+    auto startWith = [&](juce::SynthesiserSound* sound)
+    {
+        if (! sound->appliesToNote(midiNoteNumber) || ! sound->appliesToChannel(midiChannel))
+            return;
+
+        // only one velocity layer and round-robin take of the zone plays
+        if (auto* sampler = dynamic_cast<TintinSamplerSound*>(sound))
+            if (! sampler->getLayer().isPickedFor(midiVelocity, counter))
+                return;
+
+        // same as juce::Synthesiser: a retriggered note lets the old one ring out,
+        // but only the voices that are actually sounding get looked at
+        forEachActiveVoice([&](int, TintinSamplerVoice* voice)
+        {
+            if (voice->getCurrentlyPlayingNote() == midiNoteNumber
+                && voice->isPlayingChannel(midiChannel))
+                stopVoice(voice, 1.0f, true);
+        });
+
+        auto* voice = findFreeVoice(sound, midiChannel, midiNoteNumber, isNoteStealingEnabled());
+        startVoice(voice, sound, midiChannel, midiNoteNumber, velocity);
+
+        if (voice != nullptr && juce::isPositiveAndBelow(midiChannel, 17))
+            voice->setSustainPedalDown(sustainPedalsDown[(size_t) midiChannel]);
+    };
+
+    if (auto* set = soundSet.load(std::memory_order_acquire))
+    {
+        for (auto* sound: set->sounds)
+            startWith(sound);
+
+        return;
+    }
+
+    for (auto* sound: sounds)
+        startWith(sound);
+}
+
+void TintinSynth::noteOff(int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff)
+{
+    const juce::ScopedLock sl(lock);
+
+    forEachActiveVoice([&](int, TintinSamplerVoice* voice)
+    {
+        if (voice->getCurrentlyPlayingNote() != midiNoteNumber || ! voice->isPlayingChannel(midiChannel))
+            return;
+
+        if (auto sound = voice->getCurrentlyPlayingSound())
+        {
+            if (sound->appliesToNote(midiNoteNumber) && sound->appliesToChannel(midiChannel))
+            {
+                voice->setKeyDown(false);
+
+                if (! (voice->isSustainPedalDown() || voice->isSostenutoPedalDown()))
+                    stopVoice(voice, velocity, allowTailOff);
+            }
+        }
+    });
+}
+
+void TintinSynth::allNotesOff(int midiChannel, bool allowTailOff)
+{
+    const juce::ScopedLock sl(lock);
+
+    forEachActiveVoice([&](int, TintinSamplerVoice* voice)
+    {
+        if (midiChannel <= 0 || voice->isPlayingChannel(midiChannel))
+            voice->stopNote(1.0f, allowTailOff);
+    });
+
+    sustainPedalsDown.fill(false);
+}
+
+void TintinSynth::reset()
+{
+    const juce::ScopedLock sl(lock);
+
+    forEachActiveVoice([](int, TintinSamplerVoice* voice) { voice->reset(); });
+
+    sustainPedalsDown.fill(false);
+}
+
+void TintinSynth::handleSustainPedal(int midiChannel, bool isDown)
+{
+    jassert(midiChannel > 0 && midiChannel <= 16);
+    const juce::ScopedLock sl(lock);
+
+    if (juce::isPositiveAndBelow(midiChannel, 17))
+        sustainPedalsDown[(size_t) midiChannel] = isDown;
+
+    forEachActiveVoice([&](int, TintinSamplerVoice* voice)
+    {
+        if (! voice->isPlayingChannel(midiChannel))
+            return;
+
+        if (isDown)
+        {
+            if (voice->isKeyDown())
+                voice->setSustainPedalDown(true);
+
+            return;
+        }
+
+        voice->setSustainPedalDown(false);
+
+        if (! (voice->isKeyDown() || voice->isSostenutoPedalDown()))
+            stopVoice(voice, 1.0f, true);
+    });
+}
+
+void TintinSynth::handleSostenutoPedal(int midiChannel, bool isDown)
+{
+    jassert(midiChannel > 0 && midiChannel <= 16);
+    const juce::ScopedLock sl(lock);
+
+    forEachActiveVoice([&](int, TintinSamplerVoice* voice)
+    {
+        if (! voice->isPlayingChannel(midiChannel))
+            return;
+
+        if (isDown)
+            voice->setSostenutoPedalDown(true);
+        else if (voice->isSostenutoPedalDown())
+            stopVoice(voice, 1.0f, true);
+    });
+}
+
+juce::SynthesiserVoice* TintinSynth::findFreeVoice(juce::SynthesiserSound* sound,
+                                                   int midiChannel,
+                                                   int midiNoteNumber,
+                                                   bool stealIfNoneAvailable) const
+{
+    const juce::ScopedLock sl(lock);
+
+    for (size_t w = 0; w < numWords; ++w)
+    {
+        if (auto free = ~activeMask[w] & limitBits(w); free != 0)
+            return voices.getUnchecked((int) (w * 64) + std::countr_zero(free));
+    }
+
+    if (stealIfNoneAvailable)
+        return findVoiceToSteal(sound, midiChannel, midiNoteNumber);
+
+    return nullptr;
+}
+
+juce::SynthesiserVoice* TintinSynth::findVoiceToSteal(juce::SynthesiserSound*,
+                                                      int,
+                                                      int midiNoteNumber) const
+{
+    // the lowest and highest held keys carry bass and melody, steal them last
+    int lowestHeld = 128;
+    int highestHeld = -1;
+
+    forEachActiveVoice([&](int, TintinSamplerVoice* voice)
+    {
+        if (voice->isKeyDown())
+        {
+            lowestHeld = juce::jmin(lowestHeld, voice->getCurrentlyPlayingNote());
+            highestHeld = juce::jmax(highestHeld, voice->getCurrentlyPlayingNote());
+        }
+    });
+
+    // lower rank is stolen first, ties go to the quieter voice
+    auto rankOf = [&](const TintinSamplerVoice* voice)
+    {
+        if (! voice->isVoiceActive())
+            return 0; // only fading out an earlier steal
+
+        if (voice->getCurrentlyPlayingNote() == midiNoteNumber)
+            return 1; // a duplicate of the note being started
+
+        if (voice->isReleasing() || ! voice->isKeyDown())
+            return 2; // release or sustain-pedal tail
+
+        auto note = voice->getCurrentlyPlayingNote();
+        return (note == lowestHeld || note == highestHeld) ? 4 : 3;
+    };
+
+    TintinSamplerVoice* best = nullptr;
+    int bestRank = 5;
+    float bestLoudness = 0.0f;
+
+    forEachActiveVoice([&](int index, TintinSamplerVoice* voice)
+    {
+        if (index >= voiceLimit)
+            return;
+
+        auto rank = rankOf(voice);
+        auto loudness = voice->getLoudness();
+
+        if (rank < bestRank || (rank == bestRank && loudness < bestLoudness))
+        {
+            best = voice;
+            bestRank = rank;
+            bestLoudness = loudness;
+        }
+    });
+
+    // the voice is hard-stopped by startVoice, which TintinSamplerVoice turns into a short fade
+    return best;
+}
+
+void TintinSynth::renderVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (parallelThreshold > 0 && workerPool != nullptr && numSamples <= scratchSize
+        && buffer.getNumChannels() >= 1 && buffer.getNumChannels() <= 2)
+    {
+        auto numActive = getNumActiveVoices();
+
+        if (numActive > 1 && numActive >= parallelThreshold && numActive <= scratchVoices
+            && renderParallel(buffer, startSample, numSamples))
+            return;
+    }
+
+    // each mask word is walked from a copy, so voices may clear their own bit here
+    forEachActiveVoice([&](int, TintinSamplerVoice* voice)
+    { voice->renderNextBlock(buffer, startSample, numSamples); });
+}
+
+bool TintinSynth::renderParallel(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    int numJobs = 0;
+    forEachActiveVoice([&](int index, TintinSamplerVoice*) { parallelVoices[(size_t) numJobs++] = index; });
+
+    auto numChannels = buffer.getNumChannels();
+
+    auto render = [&](int job)
+    {
+        auto index = parallelVoices[(size_t) job];
+
+        float* tail[2] = {getScratch(job, 0, 0), getScratch(job, 0, 1)};
+        float* note[2] = {getScratch(job, 1, 0), getScratch(job, 1, 1)};
+
+        // -0 and not 0: x + -0 is x for every x, so samples a voice doesn't
+        // render leave the output exactly as it was, -0 included
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            juce::FloatVectorOperations::fill(tail[ch], -0.0f, numSamples);
+            juce::FloatVectorOperations::fill(note[ch], -0.0f, numSamples);
+        }
+
+        juce::AudioBuffer<float> tailBuffer(tail, numChannels, numSamples);
+        juce::AudioBuffer<float> noteBuffer(note, numChannels, numSamples);
+
+        static_cast<TintinSamplerVoice*>(voices.getUnchecked(index))
+            ->renderSeparately(tailBuffer, noteBuffer, 0, numSamples);
+    };
+
+    if (! (*workerPool)->tryRun(numJobs, render))
+        return false;
+
+    // the kernels add each sample to the output with a single float addition, so
+    // adding the buffers in the serial order (voice by voice, tail before note)
+    // gives the same bits
+    for (int job = 0; job < numJobs; ++job)
+    {
+        auto index = parallelVoices[(size_t) job];
+
+        for (int part = 0; part < 2; ++part)
+            for (int ch = 0; ch < numChannels; ++ch)
+                juce::FloatVectorOperations::add(buffer.getWritePointer(ch, startSample),
+                                                 getScratch(job, part, ch),
+                                                 numSamples);
+
+        static_cast<TintinSamplerVoice*>(voices.getUnchecked(index))->updateActiveFlag();
+    }
+
+    return true;
+}
@@ -0,0 +1,135 @@
+// Plugins/TinTin/Source/TintinSynth.h
+#pragma once
+
+#include "TintinSampler.h"
+#include "TintinWorkerPool.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+
+// juce::Synthesiser with a preallocated pool of TintinSamplerVoices.
+// Only voices flagged active are visited when rendering, so a large pool costs
+// nothing while it's idle, and the voice limit can change without allocating.
+class TintinSynth : public juce::Synthesiser
+{
+public:
+    static constexpr int maxVoices = 128;
+
+    TintinSynth();
+    ~TintinSynth() override;
+
+    // voices at or above the limit are never started, notes already on them ring out
+    void setVoiceLimit(int numVoices) noexcept;
+    int getVoiceLimit() const noexcept { return voiceLimit; }
+
+    int getNumActiveVoices() const noexcept;
+
+    // plays this set instead of the sounds added with addSound(). Safe to call while
+    // the audio thread runs; the caller keeps the set alive for as long as it's installed
+    void setSoundSet(TintinSoundSet* set) noexcept { soundSet.store(set, std::memory_order_release); }
+    bool hasSoundSet() const noexcept { return soundSet.load(std::memory_order_acquire) != nullptr; }
+
+    // allocates streams for every voice and its stolen-note tail and starts feeding
+    // them from the shared disk thread. Call before installing a set with streamed
+    // samples, never from the audio thread; later calls do nothing
+    void prepareStreaming();
+
+    // blocks in which a voice ran out of streamed data, see TintinStreamPool
+    uint32_t getNumStreamUnderruns() const noexcept { return streams.getNumUnderruns(); }
+
+    // interpolation every voice uses from the next block on, see TintinVoiceKernels
+    void setInterpolation(TintinVoiceKernels::Interpolation newInterpolation) noexcept;
+    TintinVoiceKernels::Interpolation getInterpolation() const noexcept { return interpolation; }
+
+    // renders the voices on the shared TintinWorkerPool while at least minVoices are
+    // active (0 = never). Each voice renders into a buffer of its own and those are
+    // added up in voice order, the same float additions rendering them one after
+    // the other makes, so the output is bit-identical either way
+    void setParallelThreshold(int minVoices) noexcept { parallelThreshold = minVoices; }
+    int getParallelThreshold() const noexcept { return parallelThreshold; }
+
+    // buffers for parallel blocks of up to maxBlockSize samples with up to numVoices
+    // voices active, and the worker pool. Longer or busier blocks render serially.
+    // Never while the synth is rendering
+    void prepareParallel(int maxBlockSize, int numVoices);
+
+    void noteOn(int midiChannel, int midiNoteNumber, float velocity) override;
+
+    // as juce::Synthesiser's, but only the active voices are looked at
+    void noteOff(int midiChannel, int midiNoteNumber, float velocity, bool allowTailOff) override;
+    void allNotesOff(int midiChannel, bool allowTailOff) override;
+    void handleSustainPedal(int midiChannel, bool isDown) override;
+    void handleSostenutoPedal(int midiChannel, bool isDown) override;
+
+    // every voice silent at once, stolen-note tails included, and the pedals up.
+    // For when nothing will be rendered for a while: allNotesOff() leaves notes
+    // and tails that only end by being rendered
+    void reset();
+
+    // the lock juce::Synthesiser takes while rendering and handling MIDI. Nothing
+    // else takes it while the host is processing, so it is never contended there
+    const juce::CriticalSection& getRenderLock() const noexcept { return lock; }
+
+protected:
+    juce::SynthesiserVoice* findFreeVoice(juce::SynthesiserSound*,
+                                          int midiChannel,
+                                          int midiNoteNumber,
+                                          bool stealIfNoneAvailable) const override;
+
+    juce::SynthesiserVoice* findVoiceToSteal(juce::SynthesiserSound*,
+                                             int midiChannel,
+                                             int midiNoteNumber) const override;
+
+    void renderVoices(juce::AudioBuffer<float>&, int startSample, int numSamples) override;
+    using juce::Synthesiser::renderVoices;
+
+private:
+    static constexpr size_t numWords = (size_t) maxVoices / 64;
+
+    template <typename Fn>
+    void forEachActiveVoice(Fn&& fn) const
+    {
+        for (size_t w = 0; w < numWords; ++w)
+        {
+            for (auto bits = activeMask[w]; bits != 0; bits &= bits - 1)
+            {
+                auto index = (int) (w * 64) + std::countr_zero(bits);
+                fn(index, static_cast<TintinSamplerVoice*>(voices.getUnchecked(index)));
+            }
+        }
+    }
+
+    uint64_t limitBits(size_t word) const noexcept;
+
+    // false if the pool was busy, nothing is rendered then
+    bool renderParallel(juce::AudioBuffer<float>&, int startSample, int numSamples);
+
+    // job's tail (part 0) or note (part 1) buffer for channel
+    float* getScratch(int job, int part, int channel) const noexcept
+    {
+        return scratch.get() + (size_t) ((job * 2 + part) * 2 + channel) * (size_t) scratchSize;
+    }
+
+    // bit n set = voice n is playing or fading out, kept up to date by the voices
+    std::array<uint64_t, numWords> activeMask {};
+    std::atomic<TintinSoundSet*> soundSet {nullptr};
+
+    // note-ons per key, picks the round-robin take, see TintinSampleLayer
+    std::array<uint32_t, 128> noteOnCounts {};
+
+    // juce::Synthesiser keeps its own per channel, but only its handleSustainPedal sets them
+    std::array<bool, 17> sustainPedalsDown {};
+    int voiceLimit = 32;
+    TintinVoiceKernels::Interpolation interpolation = TintinVoiceKernels::Interpolation::linear;
+
+    int parallelThreshold = 0;
+    int scratchSize = 0;
+    int scratchVoices = 0;
+    juce::HeapBlock<float> scratch; // scratchVoices * 2 parts * 2 channels * scratchSize
+    std::array<int, maxVoices> parallelVoices {};
+    std::unique_ptr<juce::SharedResourcePointer<TintinWorkerPool>> workerPool;
+
+    TintinStreamPool streams;
+    std::unique_ptr<juce::SharedResourcePointer<TintinStreamingThread>> streamingThread;
+};
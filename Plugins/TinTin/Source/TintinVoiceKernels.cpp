@@ -0,0 +1,626 @@
+// Plugins/TinTin/Source/TintinVoiceKernels.cpp
+#include "TintinVoiceKernels.h"
+#include <juce_core/juce_core.h>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#if JUCE_INTEL
+    #include <immintrin.h>
+
+    #if JUCE_MSVC
+        #define TINTIN_TARGET_AVX2
+    #else
+        #define TINTIN_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#elif JUCE_ARM && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+    #include <arm_neon.h>
+    #define TINTIN_USE_NEON 1
+#endif
+
+namespace TintinVoiceKernels
+{
+    // every kernel derives the interpolation weight from the top 24 fraction bits
+    // and uses the same operation order, so all of them agree with the scalar path
+    static constexpr float fractionScale = 1.0f / (float) (1 << 24);
+
+    static inline int indexOf(uint64_t position)
+    {
+        return (int) (position >> fractionBits);
+    }
+
+    static inline int32_t fractionOf(uint64_t position)
+    {
+        return (int32_t) (((uint32_t) position) >> 8);
+    }
+
+    static inline float toFloat(float s) { return s; }
+    static inline float toFloat(int16_t s) { return (float) s * int16Scale; }
+
+    // renders samples [start, numSamples) of a block
+    template <typename Sample>
+    static uint64_t renderScalarFrom(const Block& b,
+                                     const Sample* inL,
+                                     const Sample* inR,
+                                     int start,
+                                     uint64_t position)
+    {
+        for (int i = start; i < b.numSamples; ++i)
+        {
+            auto index = indexOf(position);
+            auto alpha = (float) fractionOf(position) * fractionScale;
+            auto env = b.envelope + b.envelopeStep * (float) i;
+
+            auto l0 = toFloat(inL[index]);
+            auto l = l0 + alpha * (toFloat(inL[index + 1]) - l0);
+            auto r = l;
+
+            if (inR != nullptr)
+            {
+                auto r0 = toFloat(inR[index]);
+                r = r0 + alpha * (toFloat(inR[index + 1]) - r0);
+            }
+
+            l *= env * b.gainL;
+            r *= env * b.gainR;
+
+            if (b.outR != nullptr)
+            {
+                b.outL[i] += l;
+                b.outR[i] += r;
+            }
+            else
+            {
+                b.outL[i] += (l + r) * 0.5f;
+            }
+
+            position += b.increment;
+        }
+
+        return position;
+    }
+
+    template <typename Sample>
+    static uint64_t renderScalarBlock(const Block& b, const Sample* inL, const Sample* inR)
+    {
+        return renderScalarFrom(b, inL, inR, 0, b.position);
+    }
+
+    uint64_t renderScalar(const Block& b)
+    {
+        if (b.inL16 != nullptr)
+            return renderScalarBlock(b, b.inL16, b.inR16);
+
+        return renderScalarBlock(b, b.inL, b.inR);
+    }
+
+    // root pitch on a sample already at the session rate: the position stays on whole
+    // frames, so interpolating is a copy. Same result as the scalar reference, but
+    // a plain loop the compiler vectorises without gathers
+    template <typename Sample>
+    static uint64_t renderUnity(const Block& b, const Sample* inL, const Sample* inR)
+    {
+        auto index = indexOf(b.position);
+        inL += index;
+        inR = inR != nullptr ? inR + index : inL;
+
+        for (int i = 0; i < b.numSamples; ++i)
+        {
+            auto env = b.envelope + b.envelopeStep * (float) i;
+            auto l = toFloat(inL[i]) * (env * b.gainL);
+            auto r = toFloat(inR[i]) * (env * b.gainR);
+
+            if (b.outR != nullptr)
+            {
+                b.outL[i] += l;
+                b.outR[i] += r;
+            }
+            else
+            {
+                b.outL[i] += (l + r) * 0.5f;
+            }
+        }
+
+        return b.position + b.increment * (uint64_t) b.numSamples;
+    }
+
+    // cubic and sinc: gather the frames around each position, then weigh them.
+    // Scalar, they're meant for sessions that can afford them (see Interpolation)
+    template <typename Sample, int numTaps>
+    static inline void readTaps(const Sample* in, int first, int numFrames, float (&taps)[numTaps])
+    {
+        if (first >= 0 && first + numTaps <= numFrames)
+        {
+            for (int k = 0; k < numTaps; ++k)
+                taps[k] = toFloat(in[first + k]);
+
+            return;
+        }
+
+        for (int k = 0; k < numTaps; ++k)
+            taps[k] = juce::isPositiveAndBelow(first + k, numFrames) ? toFloat(in[first + k]) : 0.0f;
+    }
+
+    struct CubicTaps
+    {
+        static constexpr int numTaps = 4; // index - 1 .. index + 2
+
+        static float apply(const float (&x)[numTaps], int32_t fraction)
+        {
+            auto t = (float) fraction * fractionScale;
+
+            auto c1 = 0.5f * (x[2] - x[0]);
+            auto c2 = x[0] - 2.5f * x[1] + 2.0f * x[2] - 0.5f * x[3];
+            auto c3 = 0.5f * (x[3] - x[0]) + 1.5f * (x[1] - x[2]);
+
+            return ((c3 * t + c2) * t + c1) * t + x[1];
+        }
+    };
+
+    struct SincTaps
+    {
+        static constexpr int numTaps = 32;     // index - 15 .. index + 16
+        static constexpr int phaseBits = 8;    // table rows per frame, from the top fraction bits
+        static constexpr int numPhases = 1 << phaseBits;
+
+        // row p holds the taps for a position p / numPhases past the index, with one
+        // extra row so neighbouring rows can always be blended. Built at static
+        // initialisation, so the first voice to render sinc (on the audio thread or a
+        // worker) doesn't compute and allocate it
+        static const std::vector<float> table;
+
+        static std::vector<float> makeTable()
+        {
+            constexpr double beta = 8.6;
+            constexpr int halfWidth = numTaps / 2;
+
+            auto besselI0 = [](double x)
+            {
+                auto sum = 1.0;
+                auto term = 1.0;
+
+                for (int k = 1; k < 32 && term > sum * 1.0e-12; ++k)
+                {
+                    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                    sum += term;
+                }
+
+                return sum;
+            };
+
+            std::vector<float> rows((size_t) ((numPhases + 1) * numTaps));
+
+            for (int p = 0; p <= numPhases; ++p)
+            {
+                double weights[numTaps];
+                auto sum = 0.0;
+
+                for (int k = 0; k < numTaps; ++k)
+                {
+                    auto x = (k - (halfWidth - 1)) - (double) p / numPhases; // frames from the position
+                    auto r = x / halfWidth;
+
+                    // at whole frames the sinc is exactly 1 or 0, so phase 0 copies the source
+                    auto sinc = x == 0.0 ? 1.0
+                                : (p == 0 || p == numPhases) ? 0.0
+                                : std::sin(juce::MathConstants<double>::pi * x)
+                                      / (juce::MathConstants<double>::pi * x);
+
+                    weights[k] = std::abs(r) < 1.0 ? sinc * besselI0(beta * std::sqrt(1.0 - r * r)) : 0.0;
+                    sum += weights[k];
+                }
+
+                // unity gain at DC for every phase
+                for (int k = 0; k < numTaps; ++k)
+                    rows[(size_t) (p * numTaps + k)] = (float) (weights[k] / sum);
+            }
+
+            return rows;
+        }
+
+        static float apply(const float (&x)[numTaps], int32_t fraction)
+        {
+            constexpr int blendBits = 24 - phaseBits;
+
+            auto* row = table.data() + (fraction >> blendBits) * numTaps;
+            auto blend = (float) (fraction & ((1 << blendBits) - 1)) * (1.0f / (float) (1 << blendBits));
+
+            auto a = 0.0f;
+            auto b = 0.0f;
+
+            for (int k = 0; k < numTaps; ++k)
+            {
+                a += x[k] * row[k];
+                b += x[k] * row[k + numTaps];
+            }
+
+            return a + blend * (b - a);
+        }
+    };
+
+    const std::vector<float> SincTaps::table = SincTaps::makeTable();
+
+    template <typename Taps, typename Sample>
+    static uint64_t renderTaps(const Block& b, const Sample* inL, const Sample* inR)
+    {
+        constexpr int firstTap = 1 - Taps::numTaps / 2;
+
+        float left[Taps::numTaps];
+        float right[Taps::numTaps];
+
+        auto position = b.position;
+
+        for (int i = 0; i < b.numSamples; ++i)
+        {
+            auto index = indexOf(position);
+            auto fraction = fractionOf(position);
+            auto env = b.envelope + b.envelopeStep * (float) i;
+
+            readTaps(inL, index + firstTap, b.numFrames, left);
+            auto l = Taps::apply(left, fraction);
+            auto r = l;
+
+            if (inR != nullptr)
+            {
+                readTaps(inR, index + firstTap, b.numFrames, right);
+                r = Taps::apply(right, fraction);
+            }
+
+            l *= env * b.gainL;
+            r *= env * b.gainR;
+
+            if (b.outR != nullptr)
+            {
+                b.outL[i] += l;
+                b.outR[i] += r;
+            }
+            else
+            {
+                b.outL[i] += (l + r) * 0.5f;
+            }
+
+            position += b.increment;
+        }
+
+        return position;
+    }
+
+    template <typename Sample>
+    static uint64_t renderInterpolated(const Block& b, const Sample* inL, const Sample* inR)
+    {
+        if (b.interpolation == Interpolation::sinc)
+            return renderTaps<SincTaps>(b, inL, inR);
+
+        return renderTaps<CubicTaps>(b, inL, inR);
+    }
+
+#if JUCE_INTEL
+    // loads (in[index], in[index + 1]) for four lanes and splits them into two vectors
+    static inline void loadPairs(const float* in, const int (&idx)[4], __m128& s0, __m128& s1)
+    {
+        auto p01 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*) (in + idx[0])),
+                                (const __m64*) (in + idx[1]));
+        auto p23 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*) (in + idx[2])),
+                                (const __m64*) (in + idx[3]));
+
+        s0 = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0));
+        s1 = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+
+    // a 16 bit pair is one 32 bit load: in[index] in the low half, in[index + 1] in the high
+    static inline void loadPairs(const int16_t* in, const int (&idx)[4], __m128& s0, __m128& s1)
+    {
+        int32_t pairs[4];
+
+        for (int k = 0; k < 4; ++k)
+            std::memcpy(&pairs[k], in + idx[k], sizeof(int32_t));
+
+        auto p = _mm_loadu_si128((const __m128i*) pairs);
+        auto scale = _mm_set1_ps(int16Scale);
+
+        s0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(p, 16), 16)), scale);
+        s1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(p, 16)), scale);
+    }
+
+    template <typename Sample>
+    static uint64_t renderSSE(const Block& b, const Sample* inL, const Sample* inR)
+    {
+        alignas(16) int32_t fractions[4];
+
+        const auto ramp = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        const auto scale = _mm_set1_ps(fractionScale);
+        const auto envStart = _mm_set1_ps(b.envelope);
+        const auto envStep = _mm_set1_ps(b.envelopeStep);
+        const auto gainL = _mm_set1_ps(b.gainL);
+        const auto gainR = _mm_set1_ps(b.gainR);
+
+        auto position = b.position;
+        int i = 0;
+
+        for (; i + 4 <= b.numSamples; i += 4)
+        {
+            int idx[4];
+
+            for (int k = 0; k < 4; ++k)
+            {
+                idx[k] = indexOf(position);
+                fractions[k] = fractionOf(position);
+                position += b.increment;
+            }
+
+            auto alpha = _mm_mul_ps(_mm_cvtepi32_ps(_mm_load_si128((const __m128i*) fractions)),
+                                    scale);
+            auto env = _mm_add_ps(envStart,
+                                  _mm_mul_ps(envStep, _mm_add_ps(_mm_set1_ps((float) i), ramp)));
+
+            __m128 s0, s1;
+            loadPairs(inL, idx, s0, s1);
+
+            auto l = _mm_add_ps(s0, _mm_mul_ps(alpha, _mm_sub_ps(s1, s0)));
+            auto r = l;
+
+            if (inR != nullptr)
+            {
+                loadPairs(inR, idx, s0, s1);
+                r = _mm_add_ps(s0, _mm_mul_ps(alpha, _mm_sub_ps(s1, s0)));
+            }
+
+            l = _mm_mul_ps(l, _mm_mul_ps(env, gainL));
+            r = _mm_mul_ps(r, _mm_mul_ps(env, gainR));
+
+            _mm_storeu_ps(b.outL + i, _mm_add_ps(_mm_loadu_ps(b.outL + i), l));
+            _mm_storeu_ps(b.outR + i, _mm_add_ps(_mm_loadu_ps(b.outR + i), r));
+        }
+
+        return renderScalarFrom(b, inL, inR, i, position);
+    }
+
+    TINTIN_TARGET_AVX2 static inline void gatherPairs(const float* in, __m256i idx, __m256& s0, __m256& s1)
+    {
+        s0 = _mm256_i32gather_ps(in, idx, 4);
+        s1 = _mm256_i32gather_ps(in + 1, idx, 4);
+    }
+
+    // one 32 bit gather per pair, split like the SSE version
+    TINTIN_TARGET_AVX2 static inline void gatherPairs(const int16_t* in, __m256i idx, __m256& s0, __m256& s1)
+    {
+        auto p = _mm256_i32gather_epi32((const int*) in, idx, 2);
+        auto scale = _mm256_set1_ps(int16Scale);
+
+        s0 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(_mm256_slli_epi32(p, 16), 16)), scale);
+        s1 = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srai_epi32(p, 16)), scale);
+    }
+
+    template <typename Sample>
+    TINTIN_TARGET_AVX2 static uint64_t renderAVX2(const Block& b, const Sample* inL, const Sample* inR)
+    {
+        alignas(32) int32_t indices[8];
+        alignas(32) int32_t fractions[8];
+
+        const auto ramp = _mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f);
+        const auto scale = _mm256_set1_ps(fractionScale);
+        const auto envStart = _mm256_set1_ps(b.envelope);
+        const auto envStep = _mm256_set1_ps(b.envelopeStep);
+        const auto gainL = _mm256_set1_ps(b.gainL);
+        const auto gainR = _mm256_set1_ps(b.gainR);
+
+        auto position = b.position;
+        int i = 0;
+
+        for (; i + 8 <= b.numSamples; i += 8)
+        {
+            for (int k = 0; k < 8; ++k)
+            {
+                indices[k] = indexOf(position);
+                fractions[k] = fractionOf(position);
+                position += b.increment;
+            }
+
+            auto idx = _mm256_load_si256((const __m256i*) indices);
+            auto alpha = _mm256_mul_ps(
+                _mm256_cvtepi32_ps(_mm256_load_si256((const __m256i*) fractions)), scale);
+            auto env = _mm256_add_ps(
+                envStart, _mm256_mul_ps(envStep, _mm256_add_ps(_mm256_set1_ps((float) i), ramp)));
+
+            __m256 s0, s1;
+            gatherPairs(inL, idx, s0, s1);
+
+            auto l = _mm256_add_ps(s0, _mm256_mul_ps(alpha, _mm256_sub_ps(s1, s0)));
+            auto r = l;
+
+            if (inR != nullptr)
+            {
+                gatherPairs(inR, idx, s0, s1);
+                r = _mm256_add_ps(s0, _mm256_mul_ps(alpha, _mm256_sub_ps(s1, s0)));
+            }
+
+            l = _mm256_mul_ps(l, _mm256_mul_ps(env, gainL));
+            r = _mm256_mul_ps(r, _mm256_mul_ps(env, gainR));
+
+            _mm256_storeu_ps(b.outL + i, _mm256_add_ps(_mm256_loadu_ps(b.outL + i), l));
+            _mm256_storeu_ps(b.outR + i, _mm256_add_ps(_mm256_loadu_ps(b.outR + i), r));
+        }
+
+        return renderScalarFrom(b, inL, inR, i, position);
+    }
+#endif
+
+#if TINTIN_USE_NEON
+    template <typename Sample>
+    static uint64_t renderNEON(const Block& b, const Sample* inL, const Sample* inR)
+    {
+        alignas(16) int32_t fractions[4];
+        alignas(16) float l0[4], l1[4], r0[4], r1[4];
+        alignas(16) const float rampValues[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+
+        const auto ramp = vld1q_f32(rampValues);
+        const auto envStart = vdupq_n_f32(b.envelope);
+        const auto envStep = vdupq_n_f32(b.envelopeStep);
+        const auto gainL = vdupq_n_f32(b.gainL);
+        const auto gainR = vdupq_n_f32(b.gainR);
+
+        auto position = b.position;
+        int i = 0;
+
+        for (; i + 4 <= b.numSamples; i += 4)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                auto index = indexOf(position);
+                fractions[k] = fractionOf(position);
+
+                l0[k] = toFloat(inL[index]);
+                l1[k] = toFloat(inL[index + 1]);
+
+                if (inR != nullptr)
+                {
+                    r0[k] = toFloat(inR[index]);
+                    r1[k] = toFloat(inR[index + 1]);
+                }
+
+                position += b.increment;
+            }
+
+            // separate multiply and add (no vmla/vfma) to match the other kernels
+            auto alpha = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(fractions)), fractionScale);
+            auto env = vaddq_f32(envStart,
+                                 vmulq_f32(envStep, vaddq_f32(vdupq_n_f32((float) i), ramp)));
+
+            auto s0 = vld1q_f32(l0);
+            auto l = vaddq_f32(s0, vmulq_f32(alpha, vsubq_f32(vld1q_f32(l1), s0)));
+            auto r = l;
+
+            if (inR != nullptr)
+            {
+                s0 = vld1q_f32(r0);
+                r = vaddq_f32(s0, vmulq_f32(alpha, vsubq_f32(vld1q_f32(r1), s0)));
+            }
+
+            l = vmulq_f32(l, vmulq_f32(env, gainL));
+            r = vmulq_f32(r, vmulq_f32(env, gainR));
+
+            vst1q_f32(b.outL + i, vaddq_f32(vld1q_f32(b.outL + i), l));
+            vst1q_f32(b.outR + i, vaddq_f32(vld1q_f32(b.outR + i), r));
+        }
+
+        return renderScalarFrom(b, inL, inR, i, position);
+    }
+#endif
+
+    // one kernel per source format, picked together for this CPU
+    struct KernelChoice
+    {
+        uint64_t (*renderFloat)(const Block&, const float*, const float*) = renderScalarBlock<float>;
+        uint64_t (*render16)(const Block&, const int16_t*, const int16_t*) = renderScalarBlock<int16_t>;
+        const char* name = "scalar";
+
+        KernelChoice()
+        {
+#if JUCE_INTEL
+            if (juce::SystemStats::hasAVX2())
+            {
+                renderFloat = renderAVX2<float>;
+                render16 = renderAVX2<int16_t>;
+                name = "avx2";
+                return;
+            }
+
+            renderFloat = renderSSE<float>;
+            render16 = renderSSE<int16_t>;
+            name = "sse2";
+#elif TINTIN_USE_NEON
+            renderFloat = renderNEON<float>;
+            render16 = renderNEON<int16_t>;
+            name = "neon";
+#endif
+        }
+    };
+
+    static const KernelChoice& getChoice()
+    {
+        static const KernelChoice choice;
+        return choice;
+    }
+
+    uint64_t render(const Block& b)
+    {
+        // every interpolation copies the source on whole frames
+        auto unity = b.increment == (1ull << fractionBits) && (uint32_t) b.position == 0;
+        auto taps = b.interpolation != Interpolation::linear && b.numFrames > 0;
+
+        if (b.inL16 != nullptr)
+        {
+            if (unity)
+                return renderUnity(b, b.inL16, b.inR16);
+
+            if (taps)
+                return renderInterpolated(b, b.inL16, b.inR16);
+
+            // the vector kernels are written for stereo outputs, mono hosts are rare
+            if (b.outR == nullptr)
+                return renderScalarBlock(b, b.inL16, b.inR16);
+
+            return getChoice().render16(b, b.inL16, b.inR16);
+        }
+
+        if (unity)
+            return renderUnity(b, b.inL, b.inR);
+
+        if (taps)
+            return renderInterpolated(b, b.inL, b.inR);
+
+        if (b.outR == nullptr)
+            return renderScalarBlock(b, b.inL, b.inR);
+
+        return getChoice().renderFloat(b, b.inL, b.inR);
+    }
+
+    const char* getKernelName()
+    {
+        return getChoice().name;
+    }
+
+    bool isAvailable(Kernel kernel)
+    {
+        switch (kernel)
+        {
+#if JUCE_INTEL
+            case Kernel::sse2: return true;
+            case Kernel::avx2: return juce::SystemStats::hasAVX2();
+#elif TINTIN_USE_NEON
+            case Kernel::neon: return true;
+#endif
+            default: return false;
+        }
+    }
+
+    template <typename Sample>
+    static uint64_t renderWith(Kernel kernel, const Block& b, const Sample* inL, const Sample* inR)
+    {
+        switch (kernel)
+        {
+#if JUCE_INTEL
+            case Kernel::sse2: return renderSSE(b, inL, inR);
+            case Kernel::avx2: return renderAVX2(b, inL, inR);
+#elif TINTIN_USE_NEON
+            case Kernel::neon: return renderNEON(b, inL, inR);
+#endif
+            default: return renderScalarBlock(b, inL, inR);
+        }
+    }
+
+    uint64_t renderWith(Kernel kernel, const Block& b)
+    {
+        if (! isAvailable(kernel) || b.outR == nullptr)
+        {
+            jassertfalse;
+            return renderScalar(b);
+        }
+
+        if (b.inL16 != nullptr)
+            return renderWith(kernel, b, b.inL16, b.inR16);
+
+        return renderWith(kernel, b, b.inL, b.inR);
+    }
+}
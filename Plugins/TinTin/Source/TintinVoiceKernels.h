@@ -0,0 +1,84 @@
+// Plugins/TinTin/Source/TintinVoiceKernels.h
+#pragma once
+
+#include <cstdint>
+
+// inner loops of the sampler voice: linear interpolation from a 32.32 fixed point
+// read position, envelope ramp and stereo gain applied in the same pass, added
+// straight into the output channels. One call renders one envelope segment.
+// Sources are float, or 16 bit converted to float as they're read.
+namespace TintinVoiceKernels
+{
+    constexpr int fractionBits = 32;
+
+    // 16 bit sources are read back as sample * int16Scale
+    constexpr float int16Scale = 1.0f / 32768.0f;
+
+    // how positions between source frames are read, in order of cost. Linear is
+    // what the vector kernels do; cubic and sinc read more frames per sample and
+    // are scalar, see Benchmarks/VoiceBenchmark.cpp for what each costs
+    enum class Interpolation
+    {
+        linear, // 2 frames
+        cubic,  // 4 frame Catmull-Rom spline
+        sinc    // 32 tap Kaiser windowed sinc from a polyphase table
+    };
+
+    inline uint64_t toFixed(double samplePosition)
+    {
+        return (uint64_t) (samplePosition * (double) (1ull << fractionBits));
+    }
+
+    struct Block
+    {
+        const float* inL = nullptr;
+        const float* inR = nullptr; // nullptr = mono source, inL feeds both sides
+
+        const int16_t* inL16 = nullptr; // used instead of inL/inR when set
+        const int16_t* inR16 = nullptr;
+
+        // cubic and sinc read up to 16 frames either side of the position and take
+        // frames outside [0, numFrames) as silence. 0 = the extent isn't known,
+        // which always renders linear
+        Interpolation interpolation = Interpolation::linear;
+        int numFrames = 0;
+
+        float* outL = nullptr;
+        float* outR = nullptr;      // nullptr = mono output, gets (l + r) / 2
+
+        int numSamples = 0;
+
+        uint64_t position = 0;      // 32.32 fixed point index into the source
+        uint64_t increment = 0;     // 32.32 fixed point pitch ratio
+
+        float envelope = 1.0f;      // envelope level at the first sample
+        float envelopeStep = 0.0f;  // linear change per sample
+        float gainL = 1.0f;
+        float gainR = 1.0f;
+    };
+
+    // renders with the best kernel this CPU supports and returns the new position.
+    // the source must be readable one sample past the last interpolated index.
+    uint64_t render(const Block& block);
+
+    // reference implementation, also used for tails shorter than one vector
+    uint64_t renderScalar(const Block& block);
+
+    const char* getKernelName();
+
+    // the vector kernels render() picks from, one by one so each can be checked
+    // against renderScalar() on any CPU that runs it. Linear interpolation into
+    // a stereo output, the blocks render() hands them
+    enum class Kernel
+    {
+        sse2,
+        avx2,
+        neon
+    };
+
+    // built into this binary and supported by this CPU
+    bool isAvailable(Kernel kernel);
+
+    // renders with that kernel, which must be available
+    uint64_t renderWith(Kernel kernel, const Block& block);
+}
@@ -0,0 +1,92 @@
+// Plugins/TinTin/Source/TintinWorkerPool.cpp
+#include "TintinWorkerPool.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+
+class TintinWorkerPool::Worker : public juce::Thread
+{
+public:
+    explicit Worker(TintinWorkerPool& owner) : juce::Thread("TinTin voice worker"), pool(owner) {}
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wake.wait(-1);
+
+            if (threadShouldExit())
+                return;
+
+            auto fpStatus = juce::FloatVectorOperations::getFpStatusRegister();
+            juce::FloatVectorOperations::setFpStatusRegister(pool.jobFpStatus);
+
+            pool.takeItems();
+
+            juce::FloatVectorOperations::setFpStatusRegister(fpStatus);
+
+            // the last worker out lets the caller go on
+            if (pool.workersLeft.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                pool.finished.signal();
+        }
+    }
+
+    juce::WaitableEvent wake;
+
+private:
+    TintinWorkerPool& pool;
+};
+
+TintinWorkerPool::TintinWorkerPool()
+{
+    auto numWorkers = juce::jlimit(0, maxWorkers, juce::SystemStats::getNumCpus() - 1);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        workers.push_back(std::make_unique<Worker>(*this));
+        workers.back()->startThread(juce::Thread::Priority::high);
+    }
+}
+
+TintinWorkerPool::~TintinWorkerPool()
+{
+    for (auto& worker: workers)
+    {
+        worker->signalThreadShouldExit();
+        worker->wake.signal();
+    }
+
+    for (auto& worker: workers)
+        worker->stopThread(1000);
+}
+
+bool TintinWorkerPool::runJob(int numItems, void (*call)(void*, int), void* context)
+{
+    if (busy.exchange(true, std::memory_order_acquire))
+        return false;
+
+    jobItems = numItems;
+    jobCall = call;
+    jobContext = context;
+    jobFpStatus = juce::FloatVectorOperations::getFpStatusRegister();
+    nextItem.store(0, std::memory_order_relaxed);
+    workersLeft.store(getNumWorkers(), std::memory_order_relaxed);
+
+    for (auto& worker: workers)
+        worker->wake.signal();
+
+    takeItems();
+
+    // every worker checks out, even one that woke too late to find an item, so
+    // none of them still reads this job when the next one is set up
+    if (! workers.empty())
+        finished.wait(-1);
+
+    busy.store(false, std::memory_order_release);
+    return true;
+}
+
+void TintinWorkerPool::takeItems() noexcept
+{
+    for (auto item = nextItem.fetch_add(1, std::memory_order_relaxed); item < jobItems;
+         item = nextItem.fetch_add(1, std::memory_order_relaxed))
+        jobCall(jobContext, item);
+}
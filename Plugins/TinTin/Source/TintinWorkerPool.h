@@ -0,0 +1,54 @@
+// Plugins/TinTin/Source/TintinWorkerPool.h
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// a fixed set of threads that every synth in the process shares (through
+// juce::SharedResourcePointer) to render voices in parallel. A job is a number of
+// items; the workers and the calling thread each take the next item not taken yet
+// until none are left, so a few expensive voices don't hold the others up.
+// One job runs at a time, a second caller is refused instead of kept waiting
+class TintinWorkerPool
+{
+public:
+    // threads next to the caller's, fewer on machines with fewer cores
+    static constexpr int maxWorkers = 7;
+
+    TintinWorkerPool();
+    ~TintinWorkerPool();
+
+    int getNumWorkers() const noexcept { return (int) workers.size(); }
+
+    // calls fn(item) once for each item in [0, numItems), from any of the threads,
+    // and returns once all of them are done. Returns false without calling fn if
+    // another job is running. Doesn't allocate. Workers take on the caller's
+    // floating point mode (denormal flushing, see juce::ScopedNoDenormals) for the job
+    template <typename Fn>
+    bool tryRun(int numItems, Fn& fn)
+    {
+        return runJob(numItems, [](void* context, int item) { (*static_cast<Fn*>(context))(item); }, &fn);
+    }
+
+private:
+    class Worker;
+
+    bool runJob(int numItems, void (*call)(void*, int), void* context);
+    void takeItems() noexcept;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // the running job, written before the workers are woken
+    std::atomic<bool> busy {false};
+    std::atomic<int> nextItem {0};
+    std::atomic<int> workersLeft {0};
+    int jobItems = 0;
+    void (*jobCall)(void*, int) = nullptr;
+    void* jobContext = nullptr;
+    intptr_t jobFpStatus = 0;
+
+    juce::WaitableEvent finished;
+};
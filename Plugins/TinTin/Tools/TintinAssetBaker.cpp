@@ -0,0 +1,188 @@
+// Plugins/TinTin/Tools/TintinAssetBaker.cpp
+// Build-time tool: converts the piano WAVs into a C++ source with aligned 16 bit
+// arrays and their metadata, see Source/TintinPianoPCM.h.
+//
+// usage: TintinAssetBaker <output.cpp> <file.wav> <rootNote> [<file.wav> <rootNote> ...]
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "TintinPianoPCM.h"
+
+static constexpr double maxSeconds = 10.0;      // same cap the sampler always used
+static constexpr float silenceThreshold = 0.001f; // -60 dBFS
+static constexpr int preRollSamples = 32;       // kept before the first audible sample
+static constexpr float targetPeak = 0.891f;      // -1 dBFS, applied to all assets together
+
+struct BakedAsset
+{
+    juce::String name;
+    int rootNote = 60;
+    double sampleRate = 44100.0;
+    int loopStart = -1;
+    int loopEnd = -1;
+    juce::AudioBuffer<float> audio;
+};
+
+static bool readAsset(juce::AudioFormatManager& formats,
+                      const juce::File& file,
+                      int rootNote,
+                      BakedAsset& asset)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+
+    if (reader == nullptr)
+        return false;
+
+    asset.name = file.getFileNameWithoutExtension();
+    asset.rootNote = rootNote;
+    asset.sampleRate = reader->sampleRate;
+
+    auto numChannels = juce::jmin(2, (int) reader->numChannels);
+    auto length = (int) juce::jmin(reader->lengthInSamples,
+                                   (juce::int64) (maxSeconds * reader->sampleRate));
+
+    juce::AudioBuffer<float> full(numChannels, length);
+    reader->read(&full, 0, length, 0, true, numChannels > 1);
+
+    // trim leading silence, keeping a little pre-roll for the attack
+    int firstAudible = length;
+
+    for (int ch = 0; ch < numChannels && firstAudible > 0; ++ch)
+    {
+        auto* data = full.getReadPointer(ch);
+
+        for (int i = 0; i < firstAudible; ++i)
+        {
+            if (std::abs(data[i]) > silenceThreshold)
+            {
+                firstAudible = i;
+                break;
+            }
+        }
+    }
+
+    auto start = juce::jmax(0, juce::jmin(firstAudible, length) - preRollSamples);
+
+    asset.audio.setSize(numChannels, length - start);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        asset.audio.copyFrom(ch, 0, full, ch, start, length - start);
+
+    auto& metadata = reader->metadataValues;
+
+    if (metadata.getValue("NumSampleLoops", "0").getIntValue() > 0)
+    {
+        asset.loopStart = juce::jmax(0, metadata.getValue("Loop0Start", "0").getIntValue() - start);
+        asset.loopEnd = juce::jmax(0, metadata.getValue("Loop0End", "0").getIntValue() - start);
+    }
+
+    return true;
+}
+
+static juce::String identifierFor(const juce::String& name)
+{
+    return juce::String("asset_") + name.retainCharacters(
+        "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
+}
+
+static void writeAsset(juce::OutputStream& out, const BakedAsset& asset)
+{
+    auto id = identifierFor(asset.name);
+
+    for (int ch = 0; ch < asset.audio.getNumChannels(); ++ch)
+    {
+        out << "alignas(32) static const int16_t " << id << "_" << ch << "[] = {\n";
+
+        auto* data = asset.audio.getReadPointer(ch);
+        auto numSamples = asset.audio.getNumSamples();
+
+        for (int i = 0; i < numSamples + TintinPianoPCM::padding; ++i)
+        {
+            // read back as value / 32768, see TintinVoiceKernels::int16Scale
+            auto value = i < numSamples ? juce::jlimit(-32768, 32767, juce::roundToInt(data[i] * 32768.0f)) : 0;
+            out << value << "," << ((i % 16 == 15) ? "\n" : "");
+        }
+
+        out << "\n};\n\n";
+    }
+
+    out << "static const int16_t* const " << id << "_channels[] = { ";
+
+    for (int ch = 0; ch < asset.audio.getNumChannels(); ++ch)
+        out << id << "_" << ch << ", ";
+
+    out << "};\n\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4 || (argc - 2) % 2 != 0)
+    {
+        std::fprintf(stderr,
+                     "usage: TintinAssetBaker <output.cpp> <file.wav> <rootNote> [...]\n");
+        return 1;
+    }
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::vector<BakedAsset> assets((size_t) (argc - 2) / 2);
+
+    for (size_t i = 0; i < assets.size(); ++i)
+    {
+        juce::File file(juce::String(argv[2 + i * 2]));
+        auto rootNote = juce::String(argv[3 + i * 2]).getIntValue();
+
+        if (! readAsset(formats, file, rootNote, assets[i]))
+        {
+            std::fprintf(stderr, "TintinAssetBaker: could not read %s\n", argv[2 + i * 2]);
+            return 1;
+        }
+    }
+
+    // one gain for every asset keeps their balance as recorded
+    float peak = 0.0f;
+
+    for (auto& asset: assets)
+        peak = juce::jmax(peak, asset.audio.getMagnitude(0, asset.audio.getNumSamples()));
+
+    if (peak > 0.0f)
+        for (auto& asset: assets)
+            asset.audio.applyGain(targetPeak / peak);
+
+    juce::File outputFile(juce::String(argv[1]));
+    outputFile.getParentDirectory().createDirectory();
+
+    juce::MemoryOutputStream out;
+
+    out << "// generated by TintinAssetBaker, do not edit\n"
+        << "#include \"TintinPianoPCM.h\"\n\n"
+        << "namespace TintinPianoPCM\n{\n\n";
+
+    for (auto& asset: assets)
+        writeAsset(out, asset);
+
+    out << "const Asset assets[] =\n{\n";
+
+    for (auto& asset: assets)
+    {
+        out << "    { \"" << asset.name << "\", "
+            << asset.rootNote << ", "
+            << juce::String(asset.sampleRate, 1) << ", "
+            << asset.audio.getNumChannels() << ", "
+            << asset.audio.getNumSamples() << ", "
+            << asset.loopStart << ", "
+            << asset.loopEnd << ", "
+            << identifierFor(asset.name) << "_channels },\n";
+    }
+
+    out << "};\n\n"
+        << "const int numAssets = " << (int) assets.size() << ";\n\n"
+        << "}\n";
+
+    if (! outputFile.replaceWithData(out.getData(), out.getDataSize()))
+    {
+        std::fprintf(stderr, "TintinAssetBaker: could not write %s\n", argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
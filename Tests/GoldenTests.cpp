@@ -0,0 +1,407 @@
+#include <catch2/catch_test_macros.hpp>
+#include <juce_audio_utils/juce_audio_utils.h>
+
+#include "PluginProcessor.h"
+
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+// Runs a fixed MIDI performance through the processor and compares what comes out
+// with the golden files in Tests/Golden, so an optimisation of the mapper,
+// scheduler or sampler can't change the output unnoticed.
+//
+// MIDI: every T-mode, scale, displacement mode and block size, with the sampler
+// off. Each output stream (event positions from the start and their bytes) must
+// hash the same as its golden one.
+//
+// Audio: every T-mode and displacement mode at each block size. The output must
+// hash the same, or else stay within audioTolerance of the golden RMS and peak of
+// every window, so kernels that round differently (another instruction set, a
+// changed order of additions) still pass while audible changes don't.
+//
+// Run with TINTIN_UPDATE_GOLDEN=1 to write the golden files from this build after
+// a deliberate change of the output. When a comparison fails, the files this build
+// would write are put in the temp folder (tintin-golden-actual) for a diff.
+//
+// midi.golden is always checked in. audio.golden depends on the embedded piano and
+// the sampler, so it only exists once it has been recorded from a reference build;
+// until then the audio test is skipped rather than failed.
+
+namespace
+{
+constexpr double sampleRate = 48000.0;
+constexpr double inputSeconds = 1.0;
+constexpr double midiSeconds = 1.75; // input plus the longest displacement used
+constexpr double audioSeconds = 2.0;
+constexpr int windowSize = 480;
+constexpr float audioTolerance = 1.0e-4f; // -80 dBFS
+constexpr int blockSizes[] = {1, 32, 512, 4096};
+
+const juce::File goldenFolder {TINTIN_GOLDEN_DIR};
+
+bool isUpdating()
+{
+    auto* update = std::getenv("TINTIN_UPDATE_GOLDEN");
+    return update != nullptr && juce::String(update) == "1";
+}
+
+// the performance: chords, overlapping notes, repeated keys and the pedal, with
+// timestamps in samples from the start
+juce::MidiMessageSequence makeInput()
+{
+    juce::MidiMessageSequence input;
+    juce::Random random(2024);
+
+    auto add = [&](const juce::MidiMessage& m, double samples) { input.addEvent(m, samples); };
+
+    for (double t = 0.0; t < inputSeconds * 0.85; t += 0.02 + 0.08 * random.nextDouble())
+    {
+        auto numNotes = 1 + random.nextInt(3);
+        auto start = std::floor(t * sampleRate);
+
+        for (int n = 0; n < numNotes; ++n)
+        {
+            auto note = 40 + random.nextInt(48);
+            auto length = std::floor((0.02 + 0.3 * random.nextDouble()) * sampleRate);
+
+            add(juce::MidiMessage::noteOn(1, note, (juce::uint8) (20 + random.nextInt(108))), start);
+            add(juce::MidiMessage::noteOff(1, note), start + length);
+        }
+    }
+
+    // on the first sample and either side of the largest block boundary
+    for (auto position: {0.0, 4095.0, 4096.0})
+    {
+        add(juce::MidiMessage::noteOn(1, 72, (juce::uint8) 100), position);
+        add(juce::MidiMessage::noteOff(1, 72), position + 2000.0);
+    }
+
+    add(juce::MidiMessage::controllerEvent(1, 64, 127), 0.3 * sampleRate);
+    add(juce::MidiMessage::controllerEvent(1, 64, 0), 0.6 * sampleRate);
+
+    input.sort();
+    return input;
+}
+
+void setParameters(TinTinProcessor& processor, int mode, int scale, int displacement, bool sampler)
+{
+    auto& params = processor.getParams();
+
+    *params.modeSelect = mode;
+    *params.scaleSelect = scale;
+    *params.displacementMode = displacement;
+    *params.displacementSync = 6;
+    *params.displacementMs = 250.0f;
+    *params.samplerOn = sampler;
+}
+
+// plays input through processor block by block, calling onBlock with each block's
+// start and its output
+template <typename Fn>
+void play(TinTinProcessor& processor,
+          const juce::MidiMessageSequence& input,
+          int blockSize,
+          double seconds,
+          Fn&& onBlock)
+{
+    juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), blockSize);
+    juce::MidiBuffer midi;
+    int nextEvent = 0;
+    auto total = (juce::int64) (seconds * sampleRate);
+
+    for (juce::int64 start = 0; start < total; start += blockSize)
+    {
+        auto numSamples = (int) juce::jmin((juce::int64) blockSize, total - start);
+        midi.clear();
+
+        for (; nextEvent < input.getNumEvents(); ++nextEvent)
+        {
+            auto& m = input.getEventPointer(nextEvent)->message;
+
+            if ((juce::int64) m.getTimeStamp() >= start + numSamples)
+                break;
+
+            midi.addEvent(m, (int) ((juce::int64) m.getTimeStamp() - start));
+        }
+
+        buffer.setSize(buffer.getNumChannels(), numSamples, false, false, true);
+        processor.processBlock(buffer, midi);
+        onBlock(start, buffer, midi);
+    }
+}
+
+struct Hash
+{
+    juce::uint64 value = 14695981039346656037ull; // FNV-1a
+
+    void add(const void* data, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+            value = (value ^ static_cast<const juce::uint8*>(data)[i]) * 1099511628211ull;
+    }
+
+    juce::String toString() const { return juce::String::toHexString((juce::int64) value).paddedLeft('0', 16); }
+};
+
+// scenario name -> the rest of its line in a golden file
+using GoldenLines = std::map<juce::String, juce::String>;
+
+GoldenLines readLines(const juce::File& file)
+{
+    GoldenLines lines;
+
+    for (auto& line: juce::StringArray::fromLines(file.loadFileAsString()))
+        if (line.isNotEmpty())
+            lines[line.upToFirstOccurrenceOf(" ", false, false)] = line.fromFirstOccurrenceOf(" ", false, false);
+
+    return lines;
+}
+
+juce::String writeLines(const GoldenLines& lines)
+{
+    juce::String text;
+
+    for (auto& [name, rest]: lines)
+        text << name << " " << rest << "\n";
+
+    return text;
+}
+
+// a render's hash plus RMS and peak of each window and channel
+struct AudioPrint
+{
+    juce::String hash;
+    std::vector<float> values; // per window: rms, peak of each channel
+
+    juce::String toString() const
+    {
+        juce::String text(hash);
+
+        for (auto v: values)
+            text << " " << juce::String(v, 7);
+
+        return text;
+    }
+
+    static AudioPrint fromString(const juce::String& text)
+    {
+        auto tokens = juce::StringArray::fromTokens(text, " ", "");
+        AudioPrint print;
+        print.hash = tokens[0];
+
+        for (int i = 1; i < tokens.size(); ++i)
+            print.values.push_back(tokens[i].getFloatValue());
+
+        return print;
+    }
+};
+
+AudioPrint fingerprint(const juce::AudioBuffer<float>& audio)
+{
+    AudioPrint print;
+    Hash hash;
+
+    for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+        hash.add(audio.getReadPointer(ch), sizeof(float) * (size_t) audio.getNumSamples());
+
+    print.hash = hash.toString();
+
+    for (int start = 0; start < audio.getNumSamples(); start += windowSize)
+    {
+        auto n = juce::jmin(windowSize, audio.getNumSamples() - start);
+
+        for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+        {
+            print.values.push_back(audio.getRMSLevel(ch, start, n));
+            print.values.push_back(audio.getMagnitude(ch, start, n));
+        }
+    }
+
+    return print;
+}
+
+void writeActual(const juce::String& fileName, const GoldenLines& lines)
+{
+    auto folder = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("tintin-golden-actual");
+    folder.createDirectory();
+    folder.getChildFile(fileName).replaceWithText(writeLines(lines));
+    UNSCOPED_INFO("this build's output: " << folder.getChildFile(fileName).getFullPathName());
+}
+
+// compares actual with the golden file, or writes it when updating. A missing
+// golden file fails like a mismatch
+template <typename Compare>
+void checkAgainstGolden(const juce::String& fileName, const GoldenLines& actual, Compare&& matches)
+{
+    auto file = goldenFolder.getChildFile(fileName);
+
+    if (isUpdating())
+    {
+        goldenFolder.createDirectory();
+        REQUIRE(file.replaceWithText(writeLines(actual)));
+        WARN("wrote " << file.getFullPathName());
+        return;
+    }
+
+    if (! file.existsAsFile())
+    {
+        writeActual(fileName, actual);
+        FAIL("no " << file.getFullPathName() << ", record it with TINTIN_UPDATE_GOLDEN=1");
+    }
+
+    auto golden = readLines(file);
+    int failures = 0;
+
+    for (auto& [name, line]: actual)
+    {
+        auto found = golden.find(name);
+
+        if (found == golden.end())
+        {
+            UNSCOPED_INFO(name << ": not in " << fileName);
+            ++failures;
+        }
+        else if (! matches(found->second, line))
+        {
+            UNSCOPED_INFO(name << ": differs from " << fileName);
+            ++failures;
+        }
+    }
+
+    if (failures > 0)
+        writeActual(fileName, actual);
+
+    CHECK(failures == 0);
+}
+
+template <typename Fn>
+void withLoadedProcessor(Fn&& fn)
+{
+    TinTinProcessor processor;
+    processor.setRateAndBufferSizeDetails(sampleRate, 4096);
+    processor.prepareToPlay(sampleRate, 4096);
+
+    for (int waited = 0; (! processor.isSampleSetReady() || processor.isLoadingSamples()) && waited < 60000;
+         waited += 10)
+        juce::Thread::sleep(10);
+
+    REQUIRE(processor.isSampleSetReady());
+    fn(processor);
+}
+} // namespace
+
+TEST_CASE("MIDI output matches the golden streams")
+{
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    auto input = makeInput();
+    GoldenLines actual;
+
+    for (auto blockSize: blockSizes)
+    {
+        TinTinProcessor processor;
+
+        for (int mode = 0; mode < 6; ++mode)
+        {
+            for (int scale = 0; scale < 10; ++scale)
+            {
+                for (int displacement = 0; displacement < 3; ++displacement)
+                {
+                    setParameters(processor, mode, scale, displacement, false);
+
+                    // a fresh scheduler and orbit for every scenario
+                    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+                    processor.prepareToPlay(sampleRate, blockSize);
+
+                    Hash hash;
+                    int numEvents = 0;
+
+                    auto onBlock = [&](juce::int64 start, auto&, const juce::MidiBuffer& out)
+                    {
+                        for (const auto m: out)
+                        {
+                            auto position = start + m.samplePosition;
+                            hash.add(&position, sizeof(position));
+                            hash.add(m.data, (size_t) m.numBytes);
+                            ++numEvents;
+                        }
+                    };
+
+                    play(processor, input, blockSize, midiSeconds, onBlock);
+
+                    auto name = "mode" + juce::String(mode) + ".scale" + juce::String(scale) + ".displacement"
+                                + juce::String(displacement) + ".block" + juce::String(blockSize);
+
+                    actual[name] = juce::String(numEvents) + " " + hash.toString();
+                }
+            }
+        }
+    }
+
+    auto matches = [](const juce::String& golden, const juce::String& line) { return golden == line; };
+
+    checkAgainstGolden("midi.golden", actual, matches);
+}
+
+TEST_CASE("Rendered audio matches the golden renders")
+{
+    if (! isUpdating() && ! goldenFolder.getChildFile("audio.golden").existsAsFile())
+        SKIP("no audio.golden yet, record it from a reference build with TINTIN_UPDATE_GOLDEN=1");
+
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    auto input = makeInput();
+    GoldenLines actual;
+
+    for (auto blockSize: blockSizes)
+    {
+        for (int mode = 0; mode < 6; ++mode)
+        {
+            for (int displacement = 0; displacement < 3; ++displacement)
+            {
+                // a new instance each time, so no voice carries over from the last scenario
+                withLoadedProcessor([&](TinTinProcessor& processor)
+                {
+                    setParameters(processor, mode, 1, displacement, true);
+                    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+                    processor.prepareToPlay(sampleRate, blockSize);
+
+                    juce::AudioBuffer<float> render(processor.getTotalNumOutputChannels(),
+                                                    (int) (audioSeconds * sampleRate));
+
+                    play(processor, input, blockSize, audioSeconds, [&](juce::int64 start, auto& buffer, auto&)
+                    {
+                        for (int ch = 0; ch < render.getNumChannels(); ++ch)
+                            render.copyFrom(ch, (int) start, buffer, ch, 0, buffer.getNumSamples());
+                    });
+
+                    auto name = "mode" + juce::String(mode) + ".displacement" + juce::String(displacement)
+                                + ".block" + juce::String(blockSize);
+
+                    actual[name] = fingerprint(render).toString();
+                });
+            }
+        }
+    }
+
+    auto matches = [](const juce::String& goldenLine, const juce::String& line)
+    {
+        auto golden = AudioPrint::fromString(goldenLine);
+        auto print = AudioPrint::fromString(line);
+
+        if (golden.hash == print.hash)
+            return true;
+
+        if (golden.values.size() != print.values.size())
+            return false;
+
+        for (size_t i = 0; i < golden.values.size(); ++i)
+            if (std::abs(golden.values[i] - print.values[i]) > audioTolerance)
+                return false;
+
+        return true;
+    };
+
+    checkAgainstGolden("audio.golden", actual, matches);
+}
@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+#include <juce_audio_processors/juce_audio_processors.h>
+
+#include "PluginProcessor.h"
+
+static constexpr double sampleRate = 48000.0;
+static constexpr int blockSize = 480; // 10 ms
+
+// T notes in a block's output: anything but the M key played
+struct TNotes
+{
+    int ons = 0;
+    int offs = 0;
+};
+
+static void processBlocks(TinTinProcessor& processor, int numBlocks, TNotes& t, juce::MidiBuffer input = {})
+{
+    juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), blockSize);
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        auto midi = b == 0 ? input : juce::MidiBuffer();
+        processor.processBlock(buffer, midi);
+
+        for (const auto m: midi)
+        {
+            auto message = m.getMessage();
+
+            if (message.isNoteOnOrOff() && message.getNoteNumber() != 60)
+                (message.isNoteOn() ? t.ons : t.offs)++;
+        }
+    }
+}
+
+TEST_CASE("Switching the T mode to None lets displaced notes finish and the processor go idle")
+{
+    TinTinProcessor processor;
+    auto& params = processor.getParams();
+
+    *params.samplerOn = false; // MIDI only, so no voice keeps the processor busy
+    *params.modeSelect = 1;    // T+1
+    *params.displacementMode = 2;
+    *params.displacementMs = 100.0f;
+
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    TNotes t;
+    juce::MidiBuffer on, off;
+    on.addEvent(juce::MidiMessage::noteOn(1, 60, (juce::uint8) 100), 0);
+    off.addEvent(juce::MidiMessage::noteOff(1, 60), 0);
+
+    SECTION("with the note-on and note-off both still scheduled")
+    {
+        processBlocks(processor, 2, t, on);
+        processBlocks(processor, 1, t, off);
+        REQUIRE(processor.hasPendingTNotes());
+
+        *params.modeSelect = 0;
+        processBlocks(processor, 20, t);
+    }
+
+    SECTION("with the key still down when the T voice goes off")
+    {
+        processBlocks(processor, 15, t, on);
+        REQUIRE(t.ons == 1);
+
+        *params.modeSelect = 0;
+        processBlocks(processor, 20, t, off);
+    }
+
+    REQUIRE(t.ons == 1);
+    REQUIRE(t.offs == 1);
+    REQUIRE_FALSE(processor.hasPendingTNotes());
+}
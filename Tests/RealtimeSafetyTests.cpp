@@ -0,0 +1,402 @@
+#include <catch2/catch_test_macros.hpp>
+#include <juce_audio_utils/juce_audio_utils.h>
+
+#include "PluginProcessor.h"
+
+#include <atomic>
+#include <vector>
+
+// Runs the whole processor through parameter, block size, MIDI and sample set swap
+// scenarios and fails on any heap allocation, deallocation or mutex lock on the
+// thread calling processBlock. On Linux the C allocator, operator delete and
+// pthread_mutex_lock are interposed (the test runner is linked with -rdynamic, see
+// CMakeLists.txt); the hooks only record anything while a RealtimeScope is alive on
+// the calling thread, i.e. inside processBlock. Locks the processor declares
+// uncontended (getAudioThreadLocks()) are allowed.
+
+#if JUCE_LINUX
+
+    #include <cerrno>
+    #include <dlfcn.h>
+    #include <pthread.h>
+
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+    void* __libc_memalign(size_t, size_t);
+    void __libc_free(void*);
+}
+
+namespace
+{
+struct Violation
+{
+    juce::String what;
+    juce::String stack;
+};
+
+thread_local bool armed = false;
+thread_local bool inHook = false;
+
+std::vector<Violation> violations;
+std::vector<const void*> allowedLocks;
+
+void record(const char* what, const void* address = nullptr)
+{
+    if (! armed || inHook)
+        return;
+
+    for (auto* lock: allowedLocks)
+        if (lock == address)
+            return;
+
+    // recording allocates and may lock, which mustn't come back here
+    inHook = true;
+
+    juce::String description(what);
+
+    if (address != nullptr)
+        description << " 0x" << juce::String::toHexString((juce::pointer_sized_int) address);
+
+    violations.push_back({description, juce::SystemStats::getStackBacktrace()});
+    inHook = false;
+}
+
+// marks the calling thread as the audio thread for its lifetime
+struct RealtimeScope
+{
+    RealtimeScope() { armed = true; }
+    ~RealtimeScope() { armed = false; }
+};
+
+using MutexFunction = int (*)(pthread_mutex_t*);
+
+// the libc functions behind the lock hooks, looked up on first use rather than in
+// a static initialiser: the dynamic linker and the C++ runtime lock mutexes before
+// those have run, and a function-local static would lock one itself
+MutexFunction realFunction(std::atomic<MutexFunction>& slot, const char* name)
+{
+    auto function = slot.load(std::memory_order_acquire);
+
+    if (function == nullptr)
+    {
+        function = reinterpret_cast<MutexFunction>(dlsym(RTLD_NEXT, name));
+        slot.store(function, std::memory_order_release);
+    }
+
+    return function;
+}
+
+std::atomic<MutexFunction> realLock {nullptr};
+std::atomic<MutexFunction> realTryLock {nullptr};
+} // namespace
+
+extern "C"
+{
+    void* malloc(size_t size)
+    {
+        record("malloc");
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        record("calloc");
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, size_t size)
+    {
+        record("realloc");
+        return __libc_realloc(pointer, size);
+    }
+
+    void* aligned_alloc(size_t alignment, size_t size)
+    {
+        record("aligned_alloc");
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** pointer, size_t alignment, size_t size)
+    {
+        record("posix_memalign");
+        *pointer = __libc_memalign(alignment, size);
+        return *pointer != nullptr ? 0 : ENOMEM;
+    }
+
+    // freeing nothing is fine, anything else may take the allocator's locks
+    void free(void* pointer)
+    {
+        if (pointer != nullptr)
+            record("free");
+
+        __libc_free(pointer);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex)
+    {
+        auto real = realFunction(realLock, "pthread_mutex_lock");
+        record("pthread_mutex_lock", mutex);
+        return real(mutex);
+    }
+
+    int pthread_mutex_trylock(pthread_mutex_t* mutex)
+    {
+        auto real = realFunction(realTryLock, "pthread_mutex_trylock");
+        record("pthread_mutex_trylock", mutex);
+        return real(mutex);
+    }
+}
+
+// the same for delete, so a report names it rather than the free() it ends in. The
+// default operator new allocates with malloc, which is hooked above
+void operator delete(void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        record("operator delete");
+
+    __libc_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        record("operator delete[]");
+
+    __libc_free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+    operator delete[](pointer);
+}
+
+namespace
+{
+struct Scenario
+{
+    int mode;
+    int displacementMode;
+    int scale;
+    bool mVoice;
+    bool sampler;
+    int quality; // Live Quality: draft, cubic or sinc
+    bool swapSamples; // another sample set is loaded while the blocks run
+    int blockSize;
+
+    juce::String describe() const
+    {
+        return "mode " + juce::String(mode) + ", displacement " + juce::String(displacementMode) + ", scale "
+               + juce::String(scale) + ", M voice " + (mVoice ? "on" : "off") + ", sampler "
+               + (sampler ? "on" : "off") + ", quality " + juce::String(quality) + ", "
+               + (swapSamples ? "swapping samples, " : "") + "block " + juce::String(blockSize);
+    }
+};
+
+void apply(TinTinProcessor& processor, const Scenario& s)
+{
+    auto& params = processor.getParams();
+
+    *params.modeSelect = s.mode;
+    *params.displacementMode = s.displacementMode;
+    *params.displacementSync = 6;
+    *params.displacementMs = 250.0f;
+    *params.scaleSelect = s.scale;
+    *params.mVoiceOn = s.mVoice;
+    #if TINTIN_WITH_SAMPLER
+    *params.samplerOn = s.sampler;
+    *params.liveQuality = s.quality;
+    #endif
+}
+
+// a few seconds of sine per note, named for TintinSampleLoader, so a small preload
+// size streams them
+void writeSampleFolder(const juce::File& folder)
+{
+    constexpr double rate = 48000.0;
+
+    for (auto note: {48, 60, 72})
+    {
+        juce::AudioBuffer<float> sine(1, (int) (3.0 * rate));
+        auto step = juce::MathConstants<double>::twoPi * juce::MidiMessage::getMidiNoteInHertz(note) / rate;
+
+        for (int i = 0; i < sine.getNumSamples(); ++i)
+            sine.setSample(0, i, 0.5f * (float) std::sin(step * i));
+
+        juce::WavAudioFormat format;
+        auto stream = folder.getChildFile("Sine " + juce::String(note) + ".wav").createOutputStream();
+        REQUIRE(stream != nullptr);
+
+        std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), rate, 1, 16, {}, 0));
+        REQUIRE(writer != nullptr);
+
+        stream.release(); // the writer owns it now
+        writer->writeFromAudioSampleBuffer(sine, 0, sine.getNumSamples());
+    }
+}
+
+// a few notes, sustain pedal and pitch bend per block, more in longer blocks
+void fillBlock(juce::MidiBuffer& midi, juce::Random& random, int blockSize, bool (&held)[128])
+{
+    auto numEvents = random.nextInt(juce::jmin(8, blockSize / 16 + 2));
+
+    for (int i = 0; i < numEvents; ++i)
+    {
+        auto position = random.nextInt(blockSize);
+        auto note = 36 + random.nextInt(60);
+
+        switch (random.nextInt(8))
+        {
+            case 0:
+                midi.addEvent(juce::MidiMessage::controllerEvent(1, 64, random.nextBool() ? 127 : 0), position);
+                break;
+            case 1:
+                midi.addEvent(juce::MidiMessage::pitchWheel(1, random.nextInt(16384)), position);
+                break;
+            default:
+                if (held[note])
+                    midi.addEvent(juce::MidiMessage::noteOff(1, note), position);
+                else
+                    midi.addEvent(juce::MidiMessage::noteOn(1, note, (juce::uint8) (1 + random.nextInt(127))), position);
+
+                held[note] = ! held[note];
+        }
+    }
+}
+} // namespace
+
+TEST_CASE("processBlock doesn't allocate or lock on the audio thread")
+{
+    juce::ScopedJuceInitialiser_GUI juce;
+
+    constexpr double sampleRate = 48000.0;
+    constexpr int numScenarios = 240;
+    constexpr int blocksPerScenario = 48;
+    const int blockSizes[] = {1, 32, 480, 2048};
+
+    TinTinProcessor processor;
+    processor.setRateAndBufferSizeDetails(sampleRate, 2048);
+    processor.prepareToPlay(sampleRate, 2048);
+
+    // the embedded piano loads in the background, then again converted to the rate
+    for (int waited = 0; (! processor.isSampleSetReady() || processor.isLoadingSamples()) && waited < 60000;
+         waited += 10)
+        juce::Thread::sleep(10);
+
+    if (TinTinProcessor::hasSampler)
+        REQUIRE(processor.isSampleSetReady());
+
+    for (auto* lock: processor.getAudioThreadLocks())
+        allowedLocks.push_back(lock); // a juce::CriticalSection is its pthread_mutex_t
+
+    violations.reserve(4096);
+
+    juce::AudioBuffer<float> buffer(processor.getTotalNumOutputChannels(), 2048);
+    juce::MidiBuffer midi;
+    midi.ensureSize(8192);
+
+    // swaps go back and forth between the embedded piano and these streamed samples
+    auto sampleFolder = juce::File::createTempFile("tintin-realtime-samples");
+    REQUIRE(sampleFolder.createDirectory());
+    writeSampleFolder(sampleFolder);
+
+    juce::Random random(7);
+    bool held[128] = {};
+    juce::StringArray failedScenarios;
+    bool streamed = false;
+    int numSwaps = 0;
+
+    auto processOneBlock = [&](int blockSize, bool withEvents)
+    {
+        midi.clear();
+
+        if (withEvents)
+            fillBlock(midi, random, blockSize, held);
+
+        if (random.nextInt(4) == 0)
+            processor.getPreviewNotes().push(1, 48 + random.nextInt(24), 0.8f, random.nextBool());
+
+        buffer.setSize(buffer.getNumChannels(), blockSize, false, false, true);
+        buffer.clear();
+
+        RealtimeScope audioThread;
+        processor.processBlock(buffer, midi);
+    };
+
+    for (int i = 0; i < numScenarios; ++i)
+    {
+        Scenario s {random.nextInt(6),
+                    random.nextInt(3),
+                    random.nextInt(10),
+                    random.nextBool(),
+                    random.nextInt(4) != 0,
+                    random.nextInt(3),
+                    TinTinProcessor::hasSampler && random.nextInt(6) == 0,
+                    blockSizes[random.nextInt(4)]};
+
+        // set up happens off the audio thread, like a host changing its block size
+        processor.prepareToPlay(sampleRate, s.blockSize);
+        apply(processor, s);
+
+        auto before = violations.size();
+
+    #if TINTIN_WITH_SAMPLER
+        if (s.swapSamples)
+        {
+            // the new set replaces the old one between two of these blocks, with voices
+            // still playing (and holding) the old set's sounds
+            streamed = ! streamed;
+            processor.setSampleLibrary(streamed ? sampleFolder : juce::File(), 1024);
+            ++numSwaps;
+
+            for (auto start = juce::Time::getMillisecondCounter();
+                 processor.isLoadingSamples() && juce::Time::getMillisecondCounter() - start < 60000;)
+            {
+                processOneBlock(s.blockSize, true);
+                juce::Thread::sleep(1);
+            }
+        }
+    #endif
+
+        // the last blocks are silent, so the idle path runs too
+        for (int b = 0; b < blocksPerScenario; ++b)
+            processOneBlock(s.blockSize, b < blocksPerScenario - 8);
+
+        if (violations.size() > before)
+            failedScenarios.add(s.describe());
+    }
+
+    // the first few are enough to find the culprit, later ones are mostly repeats
+    for (size_t i = 0; i < juce::jmin(violations.size(), (size_t) 20); ++i)
+        UNSCOPED_INFO(violations[i].what << "\n" << violations[i].stack);
+
+    for (auto& s: failedScenarios)
+        UNSCOPED_INFO("in scenario: " << s);
+
+    CHECK(violations.empty());
+    allowedLocks.clear();
+
+    if (TinTinProcessor::hasSampler)
+    {
+        CHECK(numSwaps > 0);
+        CHECK(processor.getSampleLoadError().isEmpty());
+    }
+
+    sampleFolder.deleteRecursively();
+}
+
+#else
+
+TEST_CASE("processBlock doesn't allocate or lock on the audio thread")
+{
+    SKIP("the allocation and lock hooks are only implemented for Linux");
+}
+
+#endif
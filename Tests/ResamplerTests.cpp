@@ -0,0 +1,58 @@
+#include <catch2/catch_test_macros.hpp>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "TintinResampler.h"
+
+#include <cmath>
+
+static TintinSampleData::Ptr makeSine(double frequency, double sampleRate, int length)
+{
+    juce::AudioBuffer<float> sine(1, length + TintinSampleData::padding);
+
+    for (int i = 0; i < sine.getNumSamples(); ++i)
+        sine.setSample(0, i, (float) std::sin(juce::MathConstants<double>::twoPi * frequency * i / sampleRate));
+
+    TintinSampleData::Ptr sample = new TintinSampleData();
+    sample->audio = sine;
+    sample->sampleRate = sampleRate;
+    sample->length = length;
+    sample->headLength = length;
+
+    return sample;
+}
+
+// largest difference from a sine at the target rate, away from the edges
+static float errorAgainstSine(const TintinSampleData& resampled, double frequency)
+{
+    auto error = 0.0f;
+
+    for (int i = 500; i < resampled.length - 500; ++i)
+    {
+        auto expected = (float) std::sin(juce::MathConstants<double>::twoPi * frequency * i / resampled.sampleRate);
+        error = juce::jmax(error, std::abs(resampled.audio.getSample(0, i) - expected));
+    }
+
+    return error;
+}
+
+TEST_CASE("Resampling keeps the audible band intact")
+{
+    for (auto targetRate: {48000.0, 96000.0, 22050.0})
+    {
+        auto resampled = TintinResampler::resample(*makeSine(1000.0, 44100.0, 20000), targetRate);
+
+        REQUIRE(resampled != nullptr);
+        REQUIRE(resampled->sampleRate == targetRate);
+        REQUIRE(std::abs(resampled->length - 20000 * targetRate / 44100.0) < 2.0);
+        REQUIRE(errorAgainstSine(*resampled, 1000.0) < 1.0e-4f);
+    }
+}
+
+TEST_CASE("Downsampling filters out what the new rate can't hold")
+{
+    // 15 kHz is above the 11025 Hz Nyquist limit of 22050 Hz, it must not fold back
+    auto resampled = TintinResampler::resample(*makeSine(15000.0, 44100.0, 20000), 22050.0);
+
+    REQUIRE(resampled != nullptr);
+    REQUIRE(resampled->audio.getMagnitude(0, 500, resampled->length - 1000) < 1.0e-3f);
+}
@@ -0,0 +1,178 @@
+#include <catch2/catch_test_macros.hpp>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "TintinSampleBank.h"
+#include "TintinSampleLoader.h"
+
+// a stereo sample of noise, converted to the 16 bit storage banks hold
+static TintinSampleData::Ptr makeNoise(int length, double sampleRate)
+{
+    TintinSampleData source;
+    source.audio.setSize(2, length + TintinSampleData::padding);
+    source.audio.clear();
+    source.sampleRate = sampleRate;
+    source.length = length;
+    source.headLength = length;
+
+    juce::Random random(11);
+
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < length; ++i)
+            source.audio.setSample(ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+    return TintinSampleData::toInt16(source);
+}
+
+TEST_CASE("Sample bank maps back what was written")
+{
+    auto sample = makeNoise(3001, 48000.0);
+
+    TintinKeyZone low {48, 0, 53, 0};
+    TintinKeyZone high {60, 54, 127, 0};
+
+    TintinSoundSet set;
+    set.sounds.add(new TintinSamplerSound(sample, low, 0.0, 0.2, 10.0));
+    set.sounds.add(new TintinSamplerSound(sample, high, 0.01, 0.3, 0.05));
+    set.sounds.getLast()->setLayer({65, 127, 1, 2});
+
+    juce::TemporaryFile file(TintinSampleBank::fileExtension);
+    REQUIRE(TintinSampleBank::write(set, file.getFile()));
+
+    TintinSampleCache cache;
+    auto bank = TintinSampleBank::open(file.getFile(), cache);
+
+    REQUIRE(bank != nullptr);
+    REQUIRE(bank->sounds.size() == 2);
+
+    // both sounds still share one copy of the PCM
+    REQUIRE(bank->sounds[0]->getSample() == bank->sounds[1]->getSample());
+
+    for (int i = 0; i < 2; ++i)
+    {
+        auto* written = set.sounds[i];
+        auto* mapped = bank->sounds[i];
+
+        REQUIRE(mapped->getZone().rootNote == written->getZone().rootNote);
+        REQUIRE(mapped->getZone().lowNote == written->getZone().lowNote);
+        REQUIRE(mapped->getZone().highNote == written->getZone().highNote);
+        REQUIRE(mapped->getLayer().lowVelocity == written->getLayer().lowVelocity);
+        REQUIRE(mapped->getLayer().roundRobinIndex == written->getLayer().roundRobinIndex);
+        REQUIRE(mapped->getLayer().roundRobinCount == written->getLayer().roundRobinCount);
+        REQUIRE(mapped->getLength() == written->getLength());
+        REQUIRE(mapped->getEnvelopeParameters().release == written->getEnvelopeParameters().release);
+    }
+
+    auto* data = bank->sounds[0]->getSample();
+
+    REQUIRE(data->isCompact());
+    REQUIRE(data->mapping != nullptr);
+    REQUIRE(data->getNumChannels() == 2);
+    REQUIRE(data->length == sample->length);
+    REQUIRE(data->sampleRate == sample->sampleRate);
+
+    for (size_t ch = 0; ch < 2; ++ch)
+    {
+        // mapped blocks keep the alignment the vector kernels like
+        REQUIRE(reinterpret_cast<uintptr_t>(data->pcm16[ch]) % 32 == 0);
+
+        for (int i = 0; i < sample->length + TintinSampleData::padding; ++i)
+            REQUIRE(data->pcm16[ch][i] == sample->pcm16[ch][i]);
+    }
+}
+
+TEST_CASE("Damaged sample banks are refused")
+{
+    TintinSoundSet set;
+    set.sounds.add(new TintinSamplerSound(makeNoise(500, 44100.0), TintinKeyZone {}, 0.0, 0.2, 10.0));
+
+    juce::TemporaryFile file(TintinSampleBank::fileExtension);
+    REQUIRE(TintinSampleBank::write(set, file.getFile()));
+
+    juce::MemoryBlock bytes;
+    REQUIRE(file.getFile().loadFileAsData(bytes));
+
+    TintinSampleCache cache;
+
+    SECTION("cut short")
+    {
+        REQUIRE(file.getFile().replaceWithData(bytes.getData(), bytes.getSize() - 64));
+        REQUIRE(TintinSampleBank::open(file.getFile(), cache) == nullptr);
+    }
+
+    SECTION("not a bank")
+    {
+        bytes[0] = 'X';
+        REQUIRE(file.getFile().replaceWithData(bytes.getData(), bytes.getSize()));
+        REQUIRE(TintinSampleBank::open(file.getFile(), cache) == nullptr);
+    }
+}
+
+TEST_CASE("Sample bank opened under a content key shares its samples whatever its time")
+{
+    TintinSoundSet set;
+    set.sounds.add(new TintinSamplerSound(makeNoise(1000, 48000.0), TintinKeyZone {}, 0.0, 0.2, 10.0));
+
+    juce::TemporaryFile file(TintinSampleBank::fileExtension);
+    REQUIRE(TintinSampleBank::write(set, file.getFile()));
+
+    TintinSampleCache cache;
+    auto first = TintinSampleBank::open(file.getFile(), cache, "bank");
+    REQUIRE(first != nullptr);
+
+    // as the warm cache marks a bank it opens as just used
+    REQUIRE(file.getFile().setLastModificationTime(juce::Time::getCurrentTime() + juce::RelativeTime::hours(1)));
+
+    auto second = TintinSampleBank::open(file.getFile(), cache, "bank");
+    REQUIRE(second != nullptr);
+    REQUIRE(second->sounds[0]->getSample() == first->sounds[0]->getSample());
+    REQUIRE(cache.getNumEntries() == 1);
+}
+
+TEST_CASE("Warm cache keeps the most recently used banks")
+{
+    auto folder = juce::File::createTempFile("tintin-warm-cache");
+    REQUIRE(folder.createDirectory());
+
+    auto now = juce::Time::getCurrentTime();
+    juce::Array<juce::File> banks;
+
+    // bank 0 used last, each later one an hour longer ago, 1000 bytes each
+    for (int i = 0; i < 6; ++i)
+    {
+        auto bank = folder.getChildFile("bank" + juce::String(i) + TintinSampleBank::fileExtension);
+        juce::MemoryBlock bytes(1000, true);
+        REQUIRE(bank.replaceWithData(bytes.getData(), bytes.getSize()));
+        REQUIRE(bank.setLastModificationTime(now - juce::RelativeTime::hours(i)));
+        banks.add(bank);
+    }
+
+    auto other = folder.getChildFile("notes.txt");
+    REQUIRE(other.replaceWithText("not a bank"));
+
+    SECTION("by count")
+    {
+        TintinSampleLoader::trimWarmCache(folder, 4, 1 << 20);
+
+        for (int i = 0; i < 6; ++i)
+            REQUIRE(banks[i].existsAsFile() == (i < 4));
+    }
+
+    SECTION("by size")
+    {
+        TintinSampleLoader::trimWarmCache(folder, 100, 2500);
+
+        for (int i = 0; i < 6; ++i)
+            REQUIRE(banks[i].existsAsFile() == (i < 2));
+    }
+
+    SECTION("the newest stays even if it is too large alone")
+    {
+        TintinSampleLoader::trimWarmCache(folder, 100, 10);
+
+        for (int i = 0; i < 6; ++i)
+            REQUIRE(banks[i].existsAsFile() == (i == 0));
+    }
+
+    REQUIRE(other.existsAsFile());
+    folder.deleteRecursively();
+}
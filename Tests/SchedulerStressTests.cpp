@@ -0,0 +1,286 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "TintinMapper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+// Seeded random sessions at densities and delays no host session should reach,
+// checked against a plain reference model: what is due when, in which order, and
+// that every T note-on gets its note-off
+
+static constexpr double sampleRate = 48000.0;
+
+// 4 bars at 20 BPM, the longest delay the parameters allow
+static const int longestDelay = (int) (16.0 * 60.0 / 20.0 * sampleRate);
+
+// 1 to 8192 samples, log-uniform so runs of tiny blocks are as common as large ones
+static int randomBlockSize(juce::Random& random)
+{
+    return juce::jlimit(1, 8192, (int) std::exp(random.nextDouble() * std::log(8193.0)));
+}
+
+// a message that carries its place in the order events were added
+static juce::MidiMessage numbered(int index)
+{
+    return juce::MidiMessage::noteOn(1 + (index & 15), (index >> 4) & 127, (juce::uint8) (1 + (index >> 11)));
+}
+
+static int numberOf(const juce::MidiMessage& m)
+{
+    return (m.getChannel() - 1) | (m.getNoteNumber() << 4) | ((m.getVelocity() - 1) << 11);
+}
+
+TEST_CASE("Scheduler emits every event on its sample, in the order added")
+{
+    auto seed = GENERATE(1, 2, 3);
+    INFO("seed " << seed);
+
+    juce::Random random(seed);
+    TintinScheduler scheduler;
+    juce::MidiBuffer out;
+
+    struct Due
+    {
+        juce::int64 time;
+        int index;
+    };
+
+    std::vector<Due> expected, emitted;
+    juce::int64 blockStart = 0;
+    size_t mostPending = 0;
+    auto addsDue = 0.0;
+    int numAdded = 0;
+
+    // adds for three of the longest delays, about 6000 events pending at once
+    while (blockStart < 3 * (juce::int64) longestDelay || ! scheduler.isEmpty())
+    {
+        auto blockSize = randomBlockSize(random);
+        auto adding = blockStart < 3 * (juce::int64) longestDelay;
+
+        for (addsDue += adding ? 0.005 * blockSize : 0.0; addsDue >= 1.0; addsDue -= 1.0)
+        {
+            auto position = random.nextInt(blockSize);
+            int delay = 0;
+
+            switch (random.nextInt(4))
+            {
+                case 0: delay = random.nextInt(16384); break;                     // in this block or the next few
+                case 1: delay = 4800 * random.nextInt(longestDelay / 4800); break; // many on the same sample
+                default: delay = random.nextInt(longestDelay + 1); break;
+            }
+
+            scheduler.add(numbered(numAdded), delay, position);
+            expected.push_back({blockStart + position + delay, numAdded});
+            ++numAdded;
+        }
+
+        mostPending = std::max(mostPending, scheduler.getNumPending());
+
+        out.clear();
+        scheduler.processBlock(out, blockSize);
+
+        for (const auto m: out)
+        {
+            REQUIRE(m.samplePosition >= 0);
+            REQUIRE(m.samplePosition < blockSize);
+            emitted.push_back({blockStart + m.samplePosition, numberOf(m.getMessage())});
+        }
+
+        blockStart += blockSize;
+        REQUIRE(blockStart < 8 * (juce::int64) longestDelay);
+    }
+
+    REQUIRE(mostPending > 4000);
+
+    // the reference: everything by due sample, the order added where they tie
+    std::sort(expected.begin(), expected.end(), [](const Due& a, const Due& b)
+    {
+        return a.time != b.time ? a.time < b.time : a.index < b.index;
+    });
+
+    REQUIRE(emitted.size() == expected.size());
+
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        INFO("event " << i << " of " << expected.size());
+        REQUIRE(emitted[i].index == expected[i].index);
+        REQUIRE(emitted[i].time == expected[i].time);
+    }
+}
+
+TEST_CASE("Mapper T notes come when their input says and every note-on is ended")
+{
+    using TMode = TintinSettings::TMode;
+    using DM = TintinSettings::DisplacementMode;
+
+    struct Scenario
+    {
+        const char* name;
+        TMode mode;
+        DM displacement;
+        int syncIndex;
+        float ms;
+        int repeats;
+        int voices;
+        bool tempoChanges;
+    };
+
+    const Scenario scenarios[] = {{"+1, 4 bars at 20 BPM", TMode::Plus1, DM::Sync, 15, 0.0f, 0, 1, false},
+                                  {"orbit, 4 bars, tempo changes", TMode::Orbit, DM::Sync, 15, 0.0f, 3, 2, true},
+                                  {"-2, 1/16, tempo changes", TMode::Minus2, DM::Sync, 0, 0.0f, 1, 1, true},
+                                  {"+2, 2000 ms", TMode::Plus2, DM::Absolute, 0, 2000.0f, 2, 1, false},
+                                  {"orbit, no displacement", TMode::Orbit, DM::None, 0, 0.0f, 0, 3, false}};
+
+    auto index = GENERATE(0, 1, 2, 3, 4);
+    auto& scenario = scenarios[index];
+    INFO(scenario.name);
+
+    juce::Random random(100 + index);
+
+    TintinMapper mapper;
+    mapper.settings.mode = scenario.mode;
+    mapper.settings.displacementMode = scenario.displacement;
+    mapper.settings.syncIndex = scenario.syncIndex;
+    mapper.settings.displacementMs = scenario.ms;
+    mapper.settings.feedbackRepeats = scenario.repeats;
+    mapper.settings.numTVoices = scenario.voices;
+    mapper.settings.scaleIndex = 1;
+    mapper.settings.bpm = 20.0;
+    mapper.prepare();
+
+    // the reference: T note-ons and note-offs due per sample, as counts
+    std::map<juce::int64, int> expectedOns, expectedOffs, actualOns, actualOffs;
+    std::map<std::pair<int, int>, int> sounding; // T notes on per channel and key
+    int heldDelay[16][128] = {};
+    bool held[16][128] = {};
+
+    auto expect = [&](std::map<juce::int64, int>& due, juce::int64 time, int delay)
+    {
+        for (int k = 1; k <= scenario.repeats + 1; ++k)
+            ++due[time + (juce::int64) delay * k];
+
+        due[time + delay] += scenario.voices - 1;
+    };
+
+    const auto inputSamples = (juce::int64) (90.0 * sampleRate);
+    juce::int64 blockStart = 0;
+    size_t mostPending = 0;
+    auto notesDue = 0.0;
+    std::vector<int> positions;
+    juce::MidiBuffer midi;
+
+    while (blockStart < inputSamples || ! mapper.scheduler.isEmpty())
+    {
+        auto blockSize = randomBlockSize(random);
+
+        if (scenario.tempoChanges && random.nextInt(200) == 0)
+            mapper.settings.bpm = juce::jlimit(20.0, 240.0, 20.0 * (1 + random.nextInt(12)));
+
+        auto settingsNow = mapper.settings;
+        settingsNow.feedbackRepeats = 0;
+        auto delay = juce::jmax(0, (int) std::round(TintinMapper::getLatestEventSeconds(settingsNow) * sampleRate));
+
+        midi.clear();
+
+        // 40 note events a second on keys that stay on the keyboard after mapping,
+        // in time order so a key's note-off never comes before its note-on
+        positions.clear();
+
+        for (notesDue += blockStart < inputSamples ? 40.0 * blockSize / sampleRate : 0.0; notesDue >= 1.0;
+             notesDue -= 1.0)
+            positions.push_back(random.nextInt(blockSize));
+
+        std::sort(positions.begin(), positions.end());
+
+        for (auto position: positions)
+        {
+            auto channel = random.nextInt(2);
+            auto key = 36 + random.nextInt(60);
+
+            if (held[channel][key])
+            {
+                midi.addEvent(juce::MidiMessage::noteOff(channel + 1, key), position);
+                expect(expectedOffs, blockStart + position, heldDelay[channel][key]);
+            }
+            else
+            {
+                midi.addEvent(juce::MidiMessage::noteOn(channel + 1, key, (juce::uint8) 100), position);
+                expect(expectedOns, blockStart + position, delay);
+                heldDelay[channel][key] = delay;
+            }
+
+            held[channel][key] = ! held[channel][key];
+        }
+
+        // then every key still down let go
+        if (blockStart < inputSamples && blockStart + blockSize >= inputSamples)
+        {
+            for (int channel = 0; channel < 16; ++channel)
+            {
+                for (int key = 0; key < 128; ++key)
+                {
+                    if (held[channel][key])
+                    {
+                        midi.addEvent(juce::MidiMessage::noteOff(channel + 1, key), blockSize - 1);
+                        expect(expectedOffs, blockStart + blockSize - 1, heldDelay[channel][key]);
+                        held[channel][key] = false;
+                    }
+                }
+            }
+        }
+
+        mapper.process(midi, sampleRate, blockSize);
+        mostPending = std::max(mostPending, mapper.getNumPending());
+
+        auto lastPosition = 0;
+
+        for (const auto m: mapper.tEvents)
+        {
+            auto message = m.getMessage();
+            auto time = blockStart + m.samplePosition;
+
+            REQUIRE(m.samplePosition >= lastPosition);
+            REQUIRE(m.samplePosition < blockSize);
+            lastPosition = m.samplePosition;
+
+            auto& count = sounding[{message.getChannel(), message.getNoteNumber()}];
+
+            if (message.isNoteOn())
+            {
+                ++actualOns[time];
+                ++count;
+            }
+            else
+            {
+                INFO("note-off of " << message.getNoteNumber() << " at sample " << time << " with no note-on");
+                REQUIRE(count > 0);
+                ++actualOffs[time];
+                --count;
+            }
+        }
+
+        blockStart += blockSize;
+        REQUIRE(blockStart < inputSamples + 8 * (juce::int64) longestDelay);
+    }
+
+    for (auto& [note, count]: sounding)
+    {
+        INFO("T note " << note.second << " on channel " << note.first);
+        REQUIRE(count == 0);
+    }
+
+    for (auto* due: {&expectedOns, &expectedOffs, &actualOns, &actualOffs})
+        for (auto it = due->begin(); it != due->end();)
+            it = it->second == 0 ? due->erase(it) : std::next(it);
+
+    REQUIRE(actualOns == expectedOns);
+    REQUIRE(actualOffs == expectedOffs);
+
+    if (scenario.syncIndex == 15 && ! scenario.tempoChanges)
+        REQUIRE(mostPending > 1000);
+}
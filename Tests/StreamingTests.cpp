@@ -0,0 +1,176 @@
+#include <catch2/catch_test_macros.hpp>
+#include <juce_audio_formats/juce_audio_formats.h>
+
+#include "TintinSampleLoader.h"
+#include "TintinSampler.h"
+
+static constexpr double sampleRate = 48000.0;
+static constexpr int blockSize = 256;
+
+// two seconds of noise written as a 32 bit float WAV, so reading it back is exact
+static void writeTestFile(const juce::File& file)
+{
+    juce::AudioBuffer<float> noise(2, (int) (2.0 * sampleRate));
+    juce::Random random(7);
+
+    for (int ch = 0; ch < noise.getNumChannels(); ++ch)
+        for (int i = 0; i < noise.getNumSamples(); ++i)
+            noise.setSample(ch, i, random.nextFloat() * 2.0f - 1.0f);
+
+    juce::WavAudioFormat format;
+    auto stream = file.createOutputStream();
+    REQUIRE(stream != nullptr);
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(
+        format.createWriterFor(stream.get(), sampleRate, 2, 32, {}, 0));
+    REQUIRE(writer != nullptr);
+
+    stream.release(); // the writer owns it now
+    writer->writeFromAudioSampleBuffer(noise, 0, noise.getNumSamples());
+}
+
+struct TestSynth
+{
+    explicit TestSynth(TintinSampleData::Ptr sample, TintinStreamPool* pool = nullptr)
+    {
+        auto* voice = new TintinSamplerVoice();
+        voice->setStreamPool(pool);
+
+        synth.addVoice(voice);
+        synth.addSound(new TintinSamplerSound(sample, TintinKeyZone {}, 0.0, 0.2, 60.0));
+        synth.setCurrentPlaybackSampleRate(sampleRate);
+
+        // a fifth up, so the playhead has a fraction and outruns the source
+        synth.noteOn(1, 67, 1.0f);
+    }
+
+    const juce::AudioBuffer<float>& render()
+    {
+        out.clear();
+        synth.renderNextBlock(out, midi, 0, blockSize);
+        return out;
+    }
+
+    juce::Synthesiser synth;
+    juce::AudioBuffer<float> out {2, blockSize};
+    juce::MidiBuffer midi;
+};
+
+TEST_CASE("Streamed sample plays the same as one loaded whole")
+{
+    juce::TemporaryFile file(".wav");
+    writeTestFile(file.getFile());
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file.getFile()));
+    REQUIRE(reader != nullptr);
+
+    auto whole = TintinSampleData::fromReader(*reader, 60.0);
+    auto streamed = TintinSampleData::preloadFile(formats, file.getFile(), 1000, 60.0);
+
+    REQUIRE(streamed != nullptr);
+    REQUIRE(streamed->isStreamed());
+    REQUIRE(streamed->headLength == 1000);
+    REQUIRE(streamed->length == whole->length);
+
+    // a small ring, so the stream wraps many times over the sample
+    TintinStreamPool pool;
+    pool.allocate(2, 4096);
+
+    TestSynth expected(whole);
+    TestSynth actual(streamed, &pool);
+
+    // until well past the end of the sample
+    for (int block = 0; block < (int) (1.5 * sampleRate) / blockSize; ++block)
+    {
+        // stands in for the disk thread: everything there is room for arrives in time
+        while (pool.service())
+            ;
+
+        const auto& e = expected.render();
+        const auto& a = actual.render();
+
+        for (int ch = 0; ch < 2; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                REQUIRE(std::abs(e.getSample(ch, i) - a.getSample(ch, i)) < 1.0e-6f);
+    }
+
+    REQUIRE(pool.getNumUnderruns() == 0);
+}
+
+TEST_CASE("Streaming voice counts underruns and waits for data")
+{
+    juce::TemporaryFile file(".wav");
+    writeTestFile(file.getFile());
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    auto streamed = TintinSampleData::preloadFile(formats, file.getFile(), 1000, 60.0);
+    REQUIRE(streamed != nullptr);
+
+    TintinStreamPool pool;
+    pool.allocate(2, 4096);
+
+    TestSynth synth(streamed, &pool);
+
+    // the head lasts ~667 output samples at this pitch: the third block runs out
+    // part way through and the fourth has nothing at all
+    for (int block = 0; block < 4; ++block)
+        synth.render();
+
+    REQUIRE(pool.getNumUnderruns() == 2);
+    REQUIRE(synth.out.getMagnitude(0, blockSize) == 0.0f);
+
+    // once the disk catches up the note carries on from where it stopped
+    while (pool.service())
+        ;
+
+    REQUIRE(synth.render().getMagnitude(0, blockSize) > 0.0f);
+    REQUIRE(pool.getNumUnderruns() == 2);
+}
+
+TEST_CASE("Sample files are matched to their root note by name")
+{
+    REQUIRE(TintinSampleLoader::parseRootNote("C4") == 60);
+    REQUIRE(TintinSampleLoader::parseRootNote("Piano_A2") == 45);
+    REQUIRE(TintinSampleLoader::parseRootNote("Grand F#3") == 54);
+    REQUIRE(TintinSampleLoader::parseRootNote("Fs3") == 54);
+    REQUIRE(TintinSampleLoader::parseRootNote("Bb2") == 46);
+    REQUIRE(TintinSampleLoader::parseRootNote("B2") == 47);
+    REQUIRE(TintinSampleLoader::parseRootNote("C-1") == 0);
+    REQUIRE(TintinSampleLoader::parseRootNote("72") == 72);
+
+    REQUIRE(TintinSampleLoader::parseRootNote("release") == -1);
+    REQUIRE(TintinSampleLoader::parseRootNote("H2") == -1);
+    REQUIRE(TintinSampleLoader::parseRootNote("200") == -1);
+}
+
+TEST_CASE("Sample file names give velocity layer and round-robin take")
+{
+    auto name = TintinSampleLoader::parseSampleName("Piano C4 v80 rr2");
+    REQUIRE(name.rootNote == 60);
+    REQUIRE(name.topVelocity == 80);
+    REQUIRE(name.roundRobin == 1);
+
+    name = TintinSampleLoader::parseSampleName("Piano_F#3_RR3_v127");
+    REQUIRE(name.rootNote == 54);
+    REQUIRE(name.topVelocity == 127);
+    REQUIRE(name.roundRobin == 2);
+
+    name = TintinSampleLoader::parseSampleName("Grand 72");
+    REQUIRE(name.rootNote == 72);
+    REQUIRE(name.topVelocity == 127);
+    REQUIRE(name.roundRobin == 0);
+
+    REQUIRE(TintinSampleLoader::parseSampleName("v80 rr2").rootNote == -1);
+
+    TintinSampleLayer layer {41, 80, 1, 2};
+    REQUIRE(! layer.isPickedFor(40, 1));
+    REQUIRE(layer.isPickedFor(41, 1));
+    REQUIRE(layer.isPickedFor(80, 3));
+    REQUIRE(! layer.isPickedFor(80, 4));
+    REQUIRE(! layer.isPickedFor(81, 1));
+}
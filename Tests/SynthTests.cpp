@@ -0,0 +1,235 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <juce_audio_basics/juce_audio_basics.h>
+
+#include "TintinSynth.h"
+
+#include <cstring>
+
+TEST_CASE("Released voices end once they fall below the silence level")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 480;
+
+    TintinSampleData::Ptr sample = new TintinSampleData();
+    sample->audio.setSize(1, (int) (4.0 * sampleRate) + TintinSampleData::padding);
+    sample->audio.clear();
+    sample->sampleRate = sampleRate;
+    sample->length = (int) (4.0 * sampleRate);
+    sample->headLength = sample->length;
+
+    for (int i = 0; i < sample->length; ++i)
+        sample->audio.setSample(0, i, 1.0f);
+
+    TintinSynth synth;
+    synth.setCurrentPlaybackSampleRate(sampleRate);
+    synth.addSound(new TintinSamplerSound(sample, TintinKeyZone {}, 0.0, 1.0, 10.0));
+
+    juce::AudioBuffer<float> out(2, blockSize);
+    juce::MidiBuffer midi;
+
+    auto renderSeconds = [&](double seconds)
+    {
+        for (int b = 0; b < (int) (seconds * sampleRate / blockSize); ++b)
+        {
+            out.clear();
+            synth.renderNextBlock(out, midi, 0, blockSize);
+            midi.clear();
+        }
+    };
+
+    // at velocity 0.001 the one second release is below -80 dB for its last 10 %
+    midi.addEvent(juce::MidiMessage::noteOn(1, 60, 0.001f), 0);
+    renderSeconds(0.1);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+
+    midi.addEvent(juce::MidiMessage::noteOff(1, 60), 0);
+    renderSeconds(0.85);
+    REQUIRE(synth.getNumActiveVoices() == 1);
+
+    renderSeconds(0.1);
+    REQUIRE(synth.getNumActiveVoices() == 0);
+}
+
+TEST_CASE("Parallel voice rendering is bit-identical to serial rendering")
+{
+    constexpr double sampleRate = 44100.0;
+    constexpr int blockSize = 256;
+
+    TintinSampleData::Ptr sample = new TintinSampleData();
+    sample->audio.setSize(2, 20000 + TintinSampleData::padding);
+    sample->audio.clear();
+    sample->sampleRate = sampleRate;
+    sample->length = 20000;
+    sample->headLength = sample->length;
+
+    juce::Random noise(3);
+
+    for (int ch = 0; ch < 2; ++ch)
+        for (int i = 0; i < sample->length; ++i)
+            sample->audio.setSample(ch, i, noise.nextFloat() * 2.0f - 1.0f);
+
+    auto interpolation = GENERATE(TintinVoiceKernels::Interpolation::linear,
+                                  TintinVoiceKernels::Interpolation::sinc);
+    auto numChannels = GENERATE(1, 2);
+
+    TintinSynth serial;
+    TintinSynth parallel;
+    parallel.prepareParallel(blockSize, 24);
+    parallel.setParallelThreshold(2);
+
+    for (auto* synth: {&serial, &parallel})
+    {
+        synth->setCurrentPlaybackSampleRate(sampleRate);
+        synth->addSound(new TintinSamplerSound(sample, TintinKeyZone {}, 0.002, 0.05, 10.0));
+        synth->setInterpolation(interpolation);
+        synth->setVoiceLimit(24); // dense enough to steal, so stolen-note tails play too
+    }
+
+    juce::AudioBuffer<float> serialOut(numChannels, blockSize);
+    juce::AudioBuffer<float> parallelOut(numChannels, blockSize);
+    juce::Random random(17);
+    int parallelBlocks = 0;
+
+    for (int block = 0; block < 400; ++block)
+    {
+        juce::MidiBuffer midi;
+
+        for (int e = 0; e < 6; ++e)
+        {
+            auto note = 36 + random.nextInt(48);
+            auto position = random.nextInt(blockSize);
+
+            if (random.nextBool())
+                midi.addEvent(juce::MidiMessage::noteOn(1, note, 0.1f + 0.9f * random.nextFloat()), position);
+            else
+                midi.addEvent(juce::MidiMessage::noteOff(1, note), position);
+        }
+
+        if (parallel.getNumActiveVoices() > 1)
+            ++parallelBlocks;
+
+        serialOut.clear();
+        parallelOut.clear();
+        serial.renderNextBlock(serialOut, midi, 0, blockSize);
+        parallel.renderNextBlock(parallelOut, midi, 0, blockSize);
+
+        REQUIRE(serial.getNumActiveVoices() == parallel.getNumActiveVoices());
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            REQUIRE(std::memcmp(serialOut.getReadPointer(ch),
+                                parallelOut.getReadPointer(ch),
+                                sizeof(float) * blockSize)
+                    == 0);
+    }
+
+    REQUIRE(parallelBlocks > 200);
+}
+
+TEST_CASE("Sustain and sostenuto pedals hold only the voices they should")
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 480;
+
+    TintinSampleData::Ptr sample = new TintinSampleData();
+    sample->audio.setSize(1, (int) sampleRate + TintinSampleData::padding);
+    sample->audio.clear();
+    sample->sampleRate = sampleRate;
+    sample->length = (int) sampleRate;
+    sample->headLength = sample->length;
+
+    for (int i = 0; i < sample->length; ++i)
+        sample->audio.setSample(0, i, 0.5f);
+
+    TintinSynth synth;
+    synth.setCurrentPlaybackSampleRate(sampleRate);
+    synth.addSound(new TintinSamplerSound(sample, TintinKeyZone {}, 0.0, 0.01, 10.0));
+
+    juce::AudioBuffer<float> out(2, blockSize);
+
+    auto play = [&](std::initializer_list<juce::MidiMessage> messages)
+    {
+        juce::MidiBuffer midi;
+
+        for (auto& m: messages)
+            midi.addEvent(m, 0);
+
+        // long enough for a 10 ms release to end
+        for (int b = 0; b < 4; ++b)
+        {
+            out.clear();
+            synth.renderNextBlock(out, midi, 0, blockSize);
+            midi.clear();
+        }
+    };
+
+    // a note started while the pedal is down is held by it too
+    play({juce::MidiMessage::controllerEvent(1, 64, 127), juce::MidiMessage::noteOn(1, 60, 1.0f)});
+    play({juce::MidiMessage::noteOff(1, 60)});
+    REQUIRE(synth.getNumActiveVoices() == 1);
+
+    play({juce::MidiMessage::controllerEvent(1, 64, 0)});
+    REQUIRE(synth.getNumActiveVoices() == 0);
+
+    // sostenuto holds the notes down when it is pressed, not the ones after
+    play({juce::MidiMessage::noteOn(1, 60, 1.0f), juce::MidiMessage::controllerEvent(1, 66, 127)});
+    play({juce::MidiMessage::noteOn(1, 64, 1.0f)});
+    play({juce::MidiMessage::noteOff(1, 60), juce::MidiMessage::noteOff(1, 64)});
+    REQUIRE(synth.getNumActiveVoices() == 1);
+
+    play({juce::MidiMessage::controllerEvent(1, 66, 0)});
+    REQUIRE(synth.getNumActiveVoices() == 0);
+
+    // all notes off ends everything, held or not
+    play({juce::MidiMessage::controllerEvent(1, 64, 127),
+          juce::MidiMessage::noteOn(1, 60, 1.0f),
+          juce::MidiMessage::noteOn(1, 62, 1.0f)});
+    synth.allNotesOff(0, true);
+    play({});
+    REQUIRE(synth.getNumActiveVoices() == 0);
+}
+
+TEST_CASE("Reset silences notes and stolen-note tails without rendering")
+{
+    constexpr double sampleRate = 48000.0;
+
+    TintinSampleData::Ptr sample = new TintinSampleData();
+    sample->audio.setSize(1, (int) sampleRate + TintinSampleData::padding);
+    sample->audio.clear();
+    sample->sampleRate = sampleRate;
+    sample->length = (int) sampleRate;
+    sample->headLength = sample->length;
+
+    for (int i = 0; i < sample->length; ++i)
+        sample->audio.setSample(0, i, 0.5f);
+
+    TintinSynth synth;
+    synth.setCurrentPlaybackSampleRate(sampleRate);
+    synth.addSound(new TintinSamplerSound(sample, TintinKeyZone {}, 0.0, 0.01, 10.0));
+
+    juce::AudioBuffer<float> out(2, 480);
+    juce::MidiBuffer midi;
+    midi.addEvent(juce::MidiMessage::controllerEvent(1, 64, 127), 0);
+    midi.addEvent(juce::MidiMessage::noteOn(1, 60, 1.0f), 0);
+    midi.addEvent(juce::MidiMessage::noteOn(1, 64, 1.0f), 0);
+    synth.renderNextBlock(out, midi, 0, out.getNumSamples());
+
+    // a hard all notes off leaves tails that only end by being rendered
+    synth.allNotesOff(0, false);
+    REQUIRE(synth.getNumActiveVoices() == 2);
+
+    synth.reset();
+    REQUIRE(synth.getNumActiveVoices() == 0);
+
+    // nothing from before comes back, and the pedal is up
+    midi.clear();
+    midi.addEvent(juce::MidiMessage::noteOn(1, 60, 1.0f), 0);
+    midi.addEvent(juce::MidiMessage::noteOff(1, 60), 1);
+    synth.renderNextBlock(out, midi, 0, out.getNumSamples());
+
+    // long enough for a 10 ms release to end
+    for (int b = 0; b < 4; ++b)
+        synth.renderNextBlock(out, juce::MidiBuffer(), 0, out.getNumSamples());
+
+    REQUIRE(synth.getNumActiveVoices() == 0);
+}
@@ -0,0 +1,201 @@
+#include <catch2/catch_test_macros.hpp>
+#include <juce_core/juce_core.h>
+
+#include "TintinVoiceKernels.h"
+
+#include <vector>
+
+using namespace TintinVoiceKernels;
+
+// the vector kernels must match the scalar reference, including the partial
+// vector at the end of a block. Not bit-exact: the compiler may fuse the scalar
+// multiply-adds on targets with FMA
+template <typename Render>
+static void checkAgainstScalar(Render&& renderBlock, bool stereoSource, bool int16Source, int numSamples, double pitchRatio)
+{
+    juce::Random random(42);
+
+    std::vector<float> left(4096), right(4096);
+    std::vector<int16_t> left16(4096), right16(4096);
+
+    for (auto& s: left)
+        s = random.nextFloat() * 2.0f - 1.0f;
+
+    for (auto& s: right)
+        s = random.nextFloat() * 2.0f - 1.0f;
+
+    for (size_t i = 0; i < left16.size(); ++i)
+    {
+        left16[i] = (int16_t) juce::roundToInt(left[i] * 32767.0f);
+        right16[i] = (int16_t) juce::roundToInt(right[i] * 32767.0f);
+    }
+
+    std::vector<float> expected((size_t) numSamples * 2, 0.25f);
+    auto actual = expected;
+
+    Block block;
+    block.inL = left.data();
+    block.inR = stereoSource ? right.data() : nullptr;
+
+    if (int16Source)
+    {
+        block.inL16 = left16.data();
+        block.inR16 = stereoSource ? right16.data() : nullptr;
+    }
+
+    block.numSamples = numSamples;
+    block.position = toFixed(3.3);
+    block.increment = toFixed(pitchRatio);
+    block.envelope = 0.2f;
+    block.envelopeStep = 0.0005f;
+    block.gainL = 0.9f;
+    block.gainR = 0.6f;
+
+    block.outL = expected.data();
+    block.outR = expected.data() + numSamples;
+    auto expectedEnd = renderScalar(block);
+
+    block.outL = actual.data();
+    block.outR = actual.data() + numSamples;
+    auto actualEnd = renderBlock(block);
+
+    REQUIRE(expectedEnd == actualEnd);
+
+    for (size_t i = 0; i < expected.size(); ++i)
+        REQUIRE(std::abs(expected[i] - actual[i]) < 1.0e-6f);
+}
+
+template <typename Render>
+static void checkAllBlocks(Render&& renderBlock)
+{
+    for (auto stereo: {false, true})
+        for (auto int16: {false, true})
+            for (auto numSamples: {1, 3, 4, 7, 8, 9, 64, 511})
+                for (auto ratio: {1.0, 0.5, 1.4983})
+                    checkAgainstScalar(renderBlock, stereo, int16, numSamples, ratio);
+}
+
+TEST_CASE("Voice kernel matches the scalar reference")
+{
+    INFO("kernel: " << getKernelName());
+    checkAllBlocks([](const Block& block) { return render(block); });
+}
+
+// render() only ever runs the best one, the others are checked here on any CPU
+// that has them
+TEST_CASE("Every vector kernel this CPU runs matches the scalar reference")
+{
+    const std::pair<Kernel, const char*> kernels[] = {{Kernel::sse2, "sse2"},
+                                                      {Kernel::avx2, "avx2"},
+                                                      {Kernel::neon, "neon"}};
+    int numTested = 0;
+
+    for (auto& [kernel, name]: kernels)
+    {
+        if (! isAvailable(kernel))
+            continue;
+
+        INFO("kernel: " << name);
+        checkAllBlocks([kernel = kernel](const Block& block) { return renderWith(kernel, block); });
+        ++numTested;
+    }
+
+    // the build's own target always has one: SSE2 on x86-64, NEON on arm64
+#if JUCE_INTEL || (JUCE_ARM && defined(__ARM_NEON))
+    REQUIRE(numTested > 0);
+#endif
+}
+
+TEST_CASE("Voice kernel at root pitch copies the source")
+{
+    std::vector<float> source {0.1f, -0.2f, 0.3f, -0.4f, 0.5f, -0.6f, 0.7f, -0.8f, 0.9f, 0.0f};
+    std::vector<float> left(8, 0.0f), right(8, 0.0f);
+
+    Block block;
+    block.inL = source.data();
+    block.outL = left.data();
+    block.outR = right.data();
+    block.numSamples = 8;
+    block.increment = toFixed(1.0);
+
+    REQUIRE(render(block) == toFixed(8.0));
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        REQUIRE(left[i] == source[i]);
+        REQUIRE(right[i] == source[i]);
+    }
+}
+
+TEST_CASE("Cubic and sinc interpolation follow a sine between the frames")
+{
+    constexpr double frequency = 3000.0 / 48000.0; // cycles per frame
+
+    std::vector<float> source(4000 + 4, 0.0f);
+
+    for (size_t i = 0; i < 4000; ++i)
+        source[i] = 0.5f * (float) std::sin(juce::MathConstants<double>::twoPi * frequency * (double) i);
+
+    auto maxError = [&](Interpolation interpolation)
+    {
+        std::vector<float> left(1000, 0.0f), right(1000, 0.0f);
+
+        Block block;
+        block.inL = source.data();
+        block.outL = left.data();
+        block.outR = right.data();
+        block.numSamples = 1000;
+        block.position = toFixed(100.25);
+        block.increment = toFixed(1.1234);
+        block.interpolation = interpolation;
+        block.numFrames = (int) source.size();
+
+        render(block);
+
+        auto error = 0.0;
+
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            auto t = 100.25 + 1.1234 * (double) i;
+            error = juce::jmax(error, std::abs(left[i] - 0.5 * std::sin(juce::MathConstants<double>::twoPi * frequency * t)));
+        }
+
+        return error;
+    };
+
+    auto linear = maxError(Interpolation::linear);
+    auto cubic = maxError(Interpolation::cubic);
+    auto sinc = maxError(Interpolation::sinc);
+
+    REQUIRE(cubic < linear / 10.0);
+    REQUIRE(sinc < 1.0e-5);
+}
+
+TEST_CASE("Every interpolation copies the source on whole frames")
+{
+    std::vector<float> source(64 + 4, 0.0f);
+    juce::Random random(3);
+
+    for (size_t i = 0; i < 64; ++i)
+        source[i] = random.nextFloat() * 2.0f - 1.0f;
+
+    for (auto interpolation: {Interpolation::cubic, Interpolation::sinc})
+    {
+        std::vector<float> left(16, 0.0f), right(16, 0.0f);
+
+        Block block;
+        block.inL = source.data();
+        block.outL = left.data();
+        block.outR = right.data();
+        block.numSamples = 16;
+        block.position = toFixed(10.0);
+        block.increment = toFixed(2.0);
+        block.interpolation = interpolation;
+        block.numFrames = (int) source.size();
+
+        render(block);
+
+        for (size_t i = 0; i < 16; ++i)
+            REQUIRE(left[i] == source[10 + 2 * i]);
+    }
+}